@@ -0,0 +1,102 @@
+#ifndef ALIGNED_ALLOCATOR_H_
+#define ALIGNED_ALLOCATOR_H_
+
+// AlignedAllocator puts a container's array on a cache line boundary (64
+// bytes by default) instead of wherever malloc felt like putting it.
+//
+//   AlignedVector<int> nums(1000);         // nums.data() % 64 == 0
+//   PaddedVector<int> padded_nums(1000);   // ...and the tail is padded
+//
+// Why bother: nums_vector from Arrays() gets whatever malloc returns, which
+// is only promised to be 16-byte aligned. For big arrays glibc hands out
+// memory 16 bytes past a page boundary, so it's misaligned for anything
+// wider than SSE. An AVX-512 load reads 64 bytes, so if the array starts 16
+// bytes into a cache line every single load straddles two lines, and the
+// CPU does two cache accesses for it instead of one. For AVX2 it's every
+// other load. aligned_bench measures what that costs.
+//
+// The third template argument pads the end of the allocation out to a
+// multiple of that many bytes. The padding past the end is zero-filled, and
+// it belongs to the allocation, so a kernel can read the whole array in full
+// vector-width chunks and never needs a scalar loop for the last few
+// elements. Keep in mind that's only the memory past capacity(). If the
+// vector has grown by push_back, the slots between size() and capacity()
+// are junk, so either mask those lanes off or build the vector at its final
+// size, like PaddedVector<int>(n), which makes capacity() == size().
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <vector>
+
+template <typename T, size_t Alignment = 64, size_t PadBytes = 0>
+class AlignedAllocator {
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "Alignment has to be a power of two.");
+
+ public:
+  using value_type = T;
+
+  // The defaulted rebind doesn't work when there are non-type template
+  // arguments, so containers that allocate something other than T (like
+  // std::list's nodes) need this.
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment, PadBytes>;
+  };
+
+  AlignedAllocator() noexcept = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment, PadBytes>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (n > kMaxCount) throw std::bad_array_new_length();
+    const size_t used = n * sizeof(T);
+    const size_t bytes = AllocatedBytes(n);
+    char* ptr = static_cast<char*>(
+        ::operator new(bytes, std::align_val_t(kAlignment)));
+    std::memset(ptr + used, 0, bytes - used);
+    return reinterpret_cast<T*>(ptr);
+  }
+  void deallocate(T* ptr, size_t n) noexcept {
+    ::operator delete(ptr, AllocatedBytes(n), std::align_val_t(kAlignment));
+  }
+
+ private:
+  static constexpr size_t kAlignment = std::max(Alignment, alignof(T));
+  static constexpr size_t kMaxCount =
+      (std::numeric_limits<size_t>::max() - PadBytes) / sizeof(T);
+
+  static size_t AllocatedBytes(size_t n) {
+    const size_t bytes = n * sizeof(T);
+    if constexpr (PadBytes == 0) {
+      return bytes;
+    } else {
+      return (bytes + PadBytes - 1) / PadBytes * PadBytes;
+    }
+  }
+};
+
+// It's all plain aligned new/delete underneath, so any two of these with the
+// same alignment and padding can free each other's memory.
+template <typename T, typename U, size_t Alignment, size_t PadBytes>
+bool operator==(const AlignedAllocator<T, Alignment, PadBytes>&,
+                const AlignedAllocator<U, Alignment, PadBytes>&) {
+  return true;
+}
+template <typename T, typename U, size_t Alignment, size_t PadBytes>
+bool operator!=(const AlignedAllocator<T, Alignment, PadBytes>&,
+                const AlignedAllocator<U, Alignment, PadBytes>&) {
+  return false;
+}
+
+template <typename T, size_t Alignment = 64>
+using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
+
+// Aligned and padded to a whole AVX-512 register (64 bytes) at the end.
+template <typename T, size_t Alignment = 64>
+using PaddedVector = std::vector<T, AlignedAllocator<T, Alignment, Alignment>>;
+
+#endif  // ALIGNED_ALLOCATOR_H_
@@ -0,0 +1,166 @@
+// How much alignment matters for SIMD loads, and what tail padding buys.
+// Run with:
+//   bazel run -c opt :aligned_bench
+//
+// BM_Sum runs simd::Sum over the same array starting 0, 4, 16 and 32 bytes
+// past a cache line boundary. 16 is what you get from std::vector for big
+// arrays (see the "alignment" lines printed at the top). Expect the
+// misaligned runs to be slower while the array fits in L1/L2, where a load
+// that splits across two lines really does cost two cache accesses, and to
+// mostly catch up once it's coming from memory, where the lines are fetched
+// either way.
+//
+// BM_SumSmall compares summing a short PaddedVector with the usual scalar
+// loop for the last few elements against reading whole vectors straight
+// through the zero padding.
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aligned_allocator.h"
+#include "benchmark/benchmark.h"
+#include "simd_kernels.h"
+
+namespace {
+
+using simd::SimdLevel;
+
+constexpr int64_t kSizes[] = {4 << 10, 64 << 10, 1 << 20, 16 << 20};
+constexpr int kOffsetBytes[] = {0, 4, 16, 32};
+
+template <typename Vector>
+void FillNums(Vector& nums) {
+  std::mt19937 rng(nums.size());
+  std::uniform_int_distribution<int> value(0, 999);
+  for (int& x : nums) x = value(rng);
+}
+
+// The biggest power of two (up to 4096) that the address is a multiple of.
+size_t AlignmentOf(const void* ptr) {
+  const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  const uintptr_t lowest_bit = address & -address;
+  return lowest_bit == 0 || lowest_bit > 4096 ? 4096 : lowest_bit;
+}
+
+void BM_Sum(benchmark::State& state, SimdLevel level, int offset_bytes) {
+  const int64_t n = state.range(0);
+  // One cache line of slack so every offset has room for all n values.
+  AlignedVector<int> storage(n + 16);
+  FillNums(storage);
+  const absl::Span<const int> nums(storage.data() + offset_bytes / sizeof(int),
+                                   n);
+  simd::SetSimdLevel(level);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::Sum(nums));
+  }
+  simd::SetSimdLevel(simd::DetectedSimdLevel());
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 8 ints, one AVX2 register. GCC and clang turn arithmetic on these into
+// vector instructions.
+typedef int Int8 __attribute__((vector_size(32)));
+
+__attribute__((target("avx2"))) int64_t SumLanes(Int8 total) {
+  int64_t sum = 0;
+  for (int i = 0; i < 8; ++i) sum += total[i];
+  return sum;
+}
+
+// The usual shape: whole vectors, then a scalar loop for the leftovers.
+__attribute__((target("avx2"))) int64_t SumWithRemainder(const int* nums,
+                                                         size_t n) {
+  Int8 total = {};
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    total += *reinterpret_cast<const Int8*>(nums + i);
+  }
+  int64_t sum = SumLanes(total);
+  for (; i < n; ++i) sum += nums[i];
+  return sum;
+}
+
+// Only valid on a PaddedVector with size() == capacity(): the last vector
+// runs into the padding, which is zero and doesn't change the sum.
+__attribute__((target("avx2"))) int64_t SumPadded(const int* nums, size_t n) {
+  Int8 total = {};
+  for (size_t i = 0; i < n; i += 8) {
+    total += *reinterpret_cast<const Int8*>(nums + i);
+  }
+  return SumLanes(total);
+}
+
+void BM_SumSmall(benchmark::State& state, bool padded) {
+  const int64_t n = state.range(0);
+  PaddedVector<int> nums(n);
+  FillNums(nums);
+  int64_t expected = 0;
+  for (int x : nums) expected += x;
+  if (SumPadded(nums.data(), n) != expected) {
+    state.SkipWithError("padding wasn't zero");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(nums.data());
+    benchmark::DoNotOptimize(padded ? SumPadded(nums.data(), n)
+                                    : SumWithRemainder(nums.data(), n));
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+#endif
+
+void RegisterAll() {
+  for (SimdLevel level : {SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    if (level > simd::DetectedSimdLevel()) continue;
+    for (int offset_bytes : kOffsetBytes) {
+      const std::string name = std::string("BM_Sum/") +
+                               simd::SimdLevelName(level) + "/offset:" +
+                               std::to_string(offset_bytes);
+      auto* bench =
+          benchmark::RegisterBenchmark(name.c_str(), BM_Sum, level,
+                                       offset_bytes);
+      for (int64_t n : kSizes) bench->Arg(n);
+    }
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  if (simd::DetectedSimdLevel() >= SimdLevel::kAvx2) {
+    for (bool padded : {false, true}) {
+      benchmark::RegisterBenchmark(
+          padded ? "BM_SumSmall/padded" : "BM_SumSmall/remainder_loop",
+          BM_SumSmall, padded)
+          ->Arg(13)
+          ->Arg(29)
+          ->Arg(61)
+          ->Arg(125);
+    }
+  }
+#endif
+}
+
+// Shows what alignment plain std::vector actually got on this machine.
+void AddAlignmentContext() {
+  for (int64_t n : kSizes) {
+    std::vector<int> nums_vector(n);
+    AlignedVector<int> aligned_nums(n);
+    benchmark::AddCustomContext(
+        "alignment of " + std::to_string(n) + " ints",
+        "std::vector " + std::to_string(AlignmentOf(nums_vector.data())) +
+            ", AlignedVector " +
+            std::to_string(AlignmentOf(aligned_nums.data())));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  RegisterAll();
+  AddAlignmentContext();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
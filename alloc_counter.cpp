@@ -0,0 +1,97 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define ALLOC_COUNTER_HAS_USABLE_SIZE 1
+#endif
+
+namespace {
+
+std::atomic<int64_t> allocations{0};
+std::atomic<int64_t> bytes_allocated{0};
+std::atomic<int64_t> live_bytes{0};
+
+void* CountedAlloc(size_t size, size_t alignment) {
+  if (size == 0) size = 1;
+  void* ptr;
+  if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ptr = std::malloc(size);
+  } else {
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    ptr = std::aligned_alloc(alignment,
+                             (size + alignment - 1) & ~(alignment - 1));
+  }
+  if (ptr == nullptr) return nullptr;
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+#ifdef ALLOC_COUNTER_HAS_USABLE_SIZE
+  live_bytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+#endif
+  return ptr;
+}
+
+void* CountedAllocOrThrow(size_t size, size_t alignment) {
+  void* ptr = CountedAlloc(size, alignment);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void CountedFree(void* ptr) {
+  if (ptr == nullptr) return;
+#ifdef ALLOC_COUNTER_HAS_USABLE_SIZE
+  live_bytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+#endif
+  std::free(ptr);
+}
+
+constexpr size_t kDefaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+}  // namespace
+
+AllocStats GetAllocStats() {
+  AllocStats stats;
+  stats.allocations = allocations.load(std::memory_order_relaxed);
+  stats.bytes_allocated = bytes_allocated.load(std::memory_order_relaxed);
+  stats.live_bytes = live_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void* operator new(size_t size) {
+  return CountedAllocOrThrow(size, kDefaultAlignment);
+}
+void* operator new[](size_t size) {
+  return CountedAllocOrThrow(size, kDefaultAlignment);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size, kDefaultAlignment);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size, kDefaultAlignment);
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+  return CountedAllocOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return CountedAllocOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  CountedFree(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  CountedFree(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  CountedFree(ptr);
+}
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  CountedFree(ptr);
+}
@@ -0,0 +1,28 @@
+#ifndef ALLOC_COUNTER_H_
+#define ALLOC_COUNTER_H_
+
+// Counts heap allocations made through global operator new. Linking
+// alloc_counter.cpp into a binary replaces operator new/delete for the whole
+// program, so only benchmarks should depend on it.
+//
+// Take a snapshot before and after the code you care about and subtract:
+//   AllocStats before = GetAllocStats();
+//   ...
+//   int64_t allocs = GetAllocStats().allocations - before.allocations;
+
+#include <cstdint>
+
+struct AllocStats {
+  // Number of calls to operator new (all forms).
+  int64_t allocations = 0;
+  // Total bytes ever requested from operator new.
+  int64_t bytes_allocated = 0;
+  // Bytes currently allocated and not yet freed, as reported by malloc. This
+  // includes malloc's rounding, so it's the real cost of what's live. Always 0
+  // on platforms without malloc_usable_size.
+  int64_t live_bytes = 0;
+};
+
+AllocStats GetAllocStats();
+
+#endif  // ALLOC_COUNTER_H_
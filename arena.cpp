@@ -0,0 +1,65 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace {
+
+// Blocks stop doubling once they get this big.
+constexpr size_t kMaxBlockSize = 1 << 20;
+
+}  // namespace
+
+// Sits at the front of every block, followed by the memory handed out.
+struct Arena::Block {
+  Block* next;
+  size_t size;  // Including this header.
+};
+
+Arena::Arena(size_t initial_block_size)
+    : next_block_size_(std::max(initial_block_size, sizeof(Block) * 2)) {}
+
+Arena::~Arena() {
+  while (blocks_ != nullptr) {
+    Block* next = blocks_->next;
+    ::operator delete(blocks_);
+    blocks_ = next;
+  }
+}
+
+void Arena::Reset() {
+  if (blocks_ == nullptr) return;
+  // Keep the newest block since it's the biggest.
+  Block* keep = blocks_;
+  Block* block = keep->next;
+  while (block != nullptr) {
+    Block* next = block->next;
+    ::operator delete(block);
+    block = next;
+  }
+  keep->next = nullptr;
+  blocks_ = nullptr;
+  bytes_reserved_ = 0;
+  StartBlock(keep);
+  bytes_used_ = 0;
+}
+
+void* Arena::AllocateSlow(size_t bytes, size_t alignment) {
+  // Room for the header plus worst case alignment padding.
+  size_t needed = sizeof(Block) + bytes + alignment;
+  size_t size = std::max(next_block_size_, needed);
+  next_block_size_ = std::min(next_block_size_ * 2, kMaxBlockSize);
+  Block* block = static_cast<Block*>(::operator new(size));
+  block->size = size;
+  StartBlock(block);
+  // Can't fail now.
+  return Allocate(bytes, alignment);
+}
+
+void Arena::StartBlock(Block* block) {
+  block->next = blocks_;
+  blocks_ = block;
+  bytes_reserved_ += block->size;
+  ptr_ = reinterpret_cast<char*>(block + 1);
+  end_ = reinterpret_cast<char*>(block) + block->size;
+}
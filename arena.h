@@ -0,0 +1,125 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+// Arena is a monotonic ("bump") allocator. It grabs memory from the heap in
+// big blocks and hands out pieces of them by just bumping a pointer forward,
+// which is a lot cheaper than a call to new. Individual deallocations do
+// nothing. Instead everything gets freed at once with Reset() or when the
+// Arena is destroyed.
+//
+// This is a good fit for request-scoped data: make an Arena per request, put
+// the request's containers in it, and throw it all away at the end. It's a
+// bad fit for anything long-lived that keeps inserting and erasing, since
+// erased memory is never reused until the Reset().
+//
+// ArenaAllocator plugs an Arena into any standard container through its
+// allocator template parameter:
+//
+//   Arena arena;
+//   using AgesAlloc = ArenaAllocator<std::pair<const std::string, int>>;
+//   using AgesMap =
+//       std::map<std::string, int, std::less<std::string>, AgesAlloc>;
+//   {
+//     AgesMap ages(AgesAlloc(&arena));
+//     ages.insert({"Brian", 40});
+//   }
+//   arena.Reset();  // Only after everything using the arena is gone.
+//
+// Note that the std::strings inside still use the regular heap if they're too
+// long for the small string buffer.
+//
+// An Arena is not thread safe.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+class Arena {
+ public:
+  // The first block is initial_block_size bytes. Each block after that is
+  // twice as big as the last, up to a limit, so big arenas don't end up with
+  // thousands of blocks.
+  explicit Arena(size_t initial_block_size = 4096);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Returns `bytes` of memory aligned to `alignment`, which has to be a power
+  // of two. Never returns null.
+  void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    uintptr_t start = (reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) &
+                      ~(alignment - 1);
+    // A fresh arena has no block at all, and without the null check a zero
+    // byte request would "fit" in it and get back nullptr.
+    if (start + bytes > reinterpret_cast<uintptr_t>(end_) || ptr_ == nullptr) {
+      return AllocateSlow(bytes, alignment);
+    }
+    ptr_ = reinterpret_cast<char*>(start + bytes);
+    bytes_used_ += bytes;
+    return reinterpret_cast<void*>(start);
+  }
+
+  // Frees everything allocated from the arena. Any container still using it
+  // is left pointing at garbage, so destroy them first. The most recent block
+  // is kept so the next request doesn't have to go back to the heap.
+  void Reset();
+
+  // Bytes handed out by Allocate() since the last Reset().
+  size_t bytes_used() const { return bytes_used_; }
+  // Bytes currently held from the heap, including unused space.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct Block;
+
+  void* AllocateSlow(size_t bytes, size_t alignment);
+  void StartBlock(Block* block);
+
+  char* ptr_ = nullptr;
+  char* end_ = nullptr;
+  // Newest block first.
+  Block* blocks_ = nullptr;
+  size_t next_block_size_;
+  size_t bytes_used_ = 0;
+  size_t bytes_reserved_ = 0;
+};
+
+// Standard allocator interface on top of an Arena. deallocate() is a no-op.
+// Copies of the allocator (including the rebound copies containers make
+// internally for their nodes) all share the same Arena.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  // Moving or swapping a container takes the arena pointer along with the
+  // memory, which is what you want since the memory lives in that arena.
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, size_t) noexcept {}
+
+  Arena* arena() const noexcept { return arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+#endif  // ARENA_H_
@@ -0,0 +1,123 @@
+// Per-request container workloads with the default allocator vs an Arena that
+// gets Reset() after every request. Run with:
+//   bazel run -c opt :arena_bench
+//
+// Each iteration is one "request": build the container, look every element
+// up once, and throw it away.
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "alloc_counter.h"
+#include "arena.h"
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "person.h"
+
+namespace {
+
+template <typename T>
+using Alloc = ArenaAllocator<T>;
+using AgesValue = std::pair<const std::string, int>;
+
+// The `ages` map from Trees().
+using AgesMap = std::map<std::string, int>;
+using ArenaAgesMap =
+    std::map<std::string, int, std::less<std::string>, Alloc<AgesValue>>;
+using AgesBTree = absl::btree_map<std::string, int>;
+using ArenaAgesBTree =
+    absl::btree_map<std::string, int, std::less<std::string>, Alloc<AgesValue>>;
+
+// The `people_set` from HashTables().
+using PeopleSet = std::unordered_set<Person, PersonNameHash, PersonNameEq>;
+using ArenaPeopleSet =
+    std::unordered_set<Person, PersonNameHash, PersonNameEq, Alloc<Person>>;
+using PeopleFlatSet = absl::flat_hash_set<Person, PersonNameHash, PersonNameEq>;
+using ArenaPeopleFlatSet =
+    absl::flat_hash_set<Person, PersonNameHash, PersonNameEq, Alloc<Person>>;
+
+using NumsVector = std::vector<int>;
+using ArenaNumsVector = std::vector<int, Alloc<int>>;
+
+// Makes an empty container, hooked up to the arena if it takes an
+// ArenaAllocator.
+template <typename C>
+C MakeContainer(Arena* arena) {
+  if constexpr (std::is_same_v<typename C::allocator_type,
+                               Alloc<typename C::value_type>>) {
+    return C(typename C::allocator_type(arena));
+  } else {
+    return C();
+  }
+}
+
+template <typename C>
+void Fill(C& c, int64_t n) {
+  if constexpr (std::is_same_v<typename C::value_type, int>) {
+    for (int64_t i = 0; i < n; ++i) c.push_back(static_cast<int>(i));
+  } else if constexpr (std::is_same_v<typename C::value_type, Person>) {
+    for (int64_t i = 0; i < n; ++i) c.insert(MakeKey<Person>(i));
+  } else {
+    for (int64_t i = 0; i < n; ++i) c.insert({MakeKey<std::string>(i), 40});
+  }
+}
+
+// Looks every element up once by key, or by index for the vectors.
+template <typename C>
+int64_t Lookup(const C& c, int64_t n) {
+  int64_t found = 0;
+  if constexpr (std::is_same_v<typename C::value_type, int>) {
+    for (int64_t i = 0; i < n; ++i) found += c[i] == i;
+  } else if constexpr (std::is_same_v<typename C::value_type, Person>) {
+    for (int64_t i = 0; i < n; ++i) found += c.count(MakeKey<Person>(i));
+  } else {
+    for (int64_t i = 0; i < n; ++i) found += c.count(MakeKey<std::string>(i));
+  }
+  return found;
+}
+
+template <typename C>
+void BM_Request(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  Arena arena;
+  AllocStats before = GetAllocStats();
+  for (auto _ : state) {
+    {
+      C c = MakeContainer<C>(&arena);
+      Fill(c, n);
+      benchmark::DoNotOptimize(Lookup(c, n));
+    }
+    arena.Reset();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.counters["allocs_per_iter"] = benchmark::Counter(
+      GetAllocStats().allocations - before.allocations,
+      benchmark::Counter::kAvgIterations);
+}
+
+void RequestSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(8, 32768);
+}
+
+BENCHMARK_TEMPLATE(BM_Request, AgesMap)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, ArenaAgesMap)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, AgesBTree)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, ArenaAgesBTree)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, PeopleSet)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, ArenaPeopleSet)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, PeopleFlatSet)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, ArenaPeopleFlatSet)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, NumsVector)->Apply(RequestSizes);
+BENCHMARK_TEMPLATE(BM_Request, ArenaNumsVector)->Apply(RequestSizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();
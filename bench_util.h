@@ -0,0 +1,149 @@
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+// Small helpers shared by the *_bench.cpp files for making keys of each type
+// used in main.cpp.
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "benchmark/benchmark.h"
+#include "person.h"
+#include "thread_pool.h"
+
+// Makes the i'th key of a given type. Names are kept short enough to fit in
+// std::string's small string buffer, like "Bill" and "Jen" do, so the string
+// benchmarks measure the container and not malloc.
+template <typename T>
+T MakeKey(int64_t i);
+
+template <>
+inline int MakeKey<int>(int64_t i) {
+  return static_cast<int>(i);
+}
+
+template <>
+inline std::string MakeKey<std::string>(int64_t i) {
+  return "n" + std::to_string(i);
+}
+
+template <>
+inline Person MakeKey<Person>(int64_t i) {
+  // Person compares by age, so age has to be unique for sets of Person.
+  return Person{MakeKey<std::string>(i), static_cast<int>(i)};
+}
+
+// Visits 0..n-1 in a scrambled order without storing a 100M element shuffled
+// index array. Multiplying by a prime that doesn't divide n and taking the
+// remainder hits every index exactly once. Inserting keys in sorted order is
+// a best case for the trees, so the benchmarks use this order instead.
+class ScrambledOrder {
+ public:
+  explicit ScrambledOrder(int64_t n) : n_(n) {}
+  int64_t operator[](int64_t i) const {
+    return static_cast<int64_t>((static_cast<uint64_t>(i) * kPrime) %
+                                static_cast<uint64_t>(n_));
+  }
+
+ private:
+  // Largest prime below 2^32. Doesn't divide any of the benchmark sizes.
+  static constexpr uint64_t kPrime = 4294967291u;
+  int64_t n_;
+};
+
+// The first `count` indexes of ScrambledOrder(n), worked out ahead of time.
+// ScrambledOrder does a 64-bit multiply and modulo per index, which costs
+// more than indexing an array does, so keep it out of timed loops.
+inline std::vector<uint32_t> ScrambledIndexes(int64_t n, int64_t count) {
+  ScrambledOrder order(n);
+  std::vector<uint32_t> indexes(count);
+  for (int64_t i = 0; i < count; ++i) {
+    indexes[i] = static_cast<uint32_t>(order[i]);
+  }
+  return indexes;
+}
+
+// n people for sorting, with the names from MakeKey in scrambled order and
+// random ages from 0 to 99, so lots of them share an age.
+inline std::vector<Person> MakePeople(int64_t n) {
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<int> age(0, 99);
+  ScrambledOrder order(n);
+  std::vector<Person> people;
+  people.reserve(n);
+  for (int64_t i = 0; i < n; ++i) {
+    people.push_back({MakeKey<std::string>(order[i]), age(rng)});
+  }
+  return people;
+}
+
+// Runs sort(values) on a fresh copy of the input every iteration. The copy
+// and freeing it afterwards aren't timed.
+template <typename T, typename Sort>
+void RunSort(benchmark::State& state, const std::vector<T>& input,
+             Sort sort) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<T> values = input;
+    state.ResumeTiming();
+    sort(values);
+    benchmark::DoNotOptimize(values.data());
+    state.PauseTiming();
+    values = {};
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// Pins the calling thread to one CPU so the scheduler can't move it around
+// mid-benchmark. CPUs past the number the machine has wrap around. Returns
+// false (and does nothing) if pinning isn't supported.
+inline bool PinThisThread(int cpu) {
+#if defined(__linux__)
+  int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu % num_cpus, &cpus);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+  return false;
+#endif
+}
+
+// For spin-wait loops in benchmarks with more threads than CPUs. Spinning
+// there just burns the time slice the other thread needs to make progress, so
+// give it up every so often.
+inline void SpinWait(int& spins) {
+  if (++spins >= 64) {
+    spins = 0;
+    std::this_thread::yield();
+  }
+}
+
+// One pool per thread count, kept around between benchmarks so thread start
+// up isn't measured.
+inline ThreadPool& PoolWithThreads(int num_threads) {
+  static auto* pools = new std::map<int, std::unique_ptr<ThreadPool>>;
+  std::unique_ptr<ThreadPool>& pool = (*pools)[num_threads];
+  if (pool == nullptr) pool = std::make_unique<ThreadPool>(num_threads);
+  return *pool;
+}
+
+// Args {size, threads} for each pool size worth trying. Anything above the
+// number of cores the machine has just adds overhead.
+inline void ThreadArgs(benchmark::internal::Benchmark* b, int64_t size) {
+  for (int threads : {1, 2, 4, 8, 16, 32, 64}) b->Args({size, threads});
+}
+
+#endif  // BENCH_UTIL_H_
@@ -0,0 +1,242 @@
+#include "bit_vector.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+// Rank and building the index are mostly popcounts. x86 has had a popcount
+// instruction since 2008, but the compiler can't assume it without
+// -mpopcnt, and without it __builtin_popcountll is a library call that
+// counts with shifts and masks. So those two get compiled both ways, and the
+// popcnt version is used when the CPU has it, same as simd_kernels.cpp does.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BIT_VECTOR_X86 1
+#define TARGET_POPCNT __attribute__((target("popcnt")))
+#endif
+
+namespace {
+
+constexpr size_t kWordsPerBlock = 8;
+
+// The bodies shared by both versions. They're always inlined so each copy
+// gets compiled with its caller's instruction set.
+
+__attribute__((always_inline)) inline size_t RankImpl(const uint64_t* words,
+                                                      const uint64_t* index,
+                                                      size_t pos) {
+  const size_t word = pos / 64;
+  const size_t block = word / kWordsPerBlock;
+  // The count before word 0 of the block is always 0 and isn't stored. For
+  // word 0, t is -1 and the shift comes out to 63, which is always a 0 bit.
+  // That's cheaper than a branch the CPU can't predict.
+  const int64_t t = static_cast<int64_t>(word % kWordsPerBlock) - 1;
+  const int shift = static_cast<int>((t + ((t >> 60) & 8)) * 9);
+  size_t rank = index[2 * block] + ((index[2 * block + 1] >> shift) & 0x1ff);
+  const unsigned bit = pos % 64;
+  if (bit != 0) {
+    rank += __builtin_popcountll(words[word] & ((uint64_t{1} << bit) - 1));
+  }
+  return rank;
+}
+
+__attribute__((always_inline)) inline size_t BuildIndexImpl(
+    const uint64_t* words, size_t num_words, size_t num_blocks,
+    uint64_t* index) {
+  size_t total = 0;
+  for (size_t block = 0; block < num_blocks; ++block) {
+    uint64_t sub_counts = 0;
+    uint64_t in_block = 0;
+    for (size_t j = 0; j < kWordsPerBlock; ++j) {
+      if (j > 0) sub_counts |= in_block << (9 * (j - 1));
+      const size_t word = block * kWordsPerBlock + j;
+      if (word < num_words) in_block += __builtin_popcountll(words[word]);
+    }
+    index[2 * block] = total;
+    index[2 * block + 1] = sub_counts;
+    total += in_block;
+  }
+  return total;
+}
+
+__attribute__((always_inline)) inline size_t CountImpl(const uint64_t* words,
+                                                       size_t num_words) {
+  size_t total = 0;
+  for (size_t i = 0; i < num_words; ++i) {
+    total += __builtin_popcountll(words[i]);
+  }
+  return total;
+}
+
+struct PopcountOps {
+  size_t (*rank)(const uint64_t* words, const uint64_t* index, size_t pos);
+  size_t (*build_index)(const uint64_t* words, size_t num_words,
+                        size_t num_blocks, uint64_t* index);
+  size_t (*count)(const uint64_t* words, size_t num_words);
+};
+
+size_t RankGeneric(const uint64_t* words, const uint64_t* index, size_t pos) {
+  return RankImpl(words, index, pos);
+}
+size_t BuildIndexGeneric(const uint64_t* words, size_t num_words,
+                         size_t num_blocks, uint64_t* index) {
+  return BuildIndexImpl(words, num_words, num_blocks, index);
+}
+size_t CountGeneric(const uint64_t* words, size_t num_words) {
+  return CountImpl(words, num_words);
+}
+constexpr PopcountOps kGenericOps = {RankGeneric, BuildIndexGeneric,
+                                     CountGeneric};
+
+#ifdef BIT_VECTOR_X86
+TARGET_POPCNT size_t RankPopcnt(const uint64_t* words, const uint64_t* index,
+                                size_t pos) {
+  return RankImpl(words, index, pos);
+}
+TARGET_POPCNT size_t BuildIndexPopcnt(const uint64_t* words, size_t num_words,
+                                      size_t num_blocks, uint64_t* index) {
+  return BuildIndexImpl(words, num_words, num_blocks, index);
+}
+TARGET_POPCNT size_t CountPopcnt(const uint64_t* words, size_t num_words) {
+  return CountImpl(words, num_words);
+}
+constexpr PopcountOps kPopcntOps = {RankPopcnt, BuildIndexPopcnt,
+                                    CountPopcnt};
+#endif
+
+const PopcountOps& Ops() {
+#ifdef BIT_VECTOR_X86
+  static const PopcountOps& ops = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("popcnt") ? kPopcntOps : kGenericOps;
+  }();
+  return ops;
+#else
+  return kGenericOps;
+#endif
+}
+
+// kSelectInByte[b][k] is the position of the k'th set bit of the byte b, for
+// k less than the number of bits set in b.
+using SelectInByteTable = std::array<std::array<uint8_t, 8>, 256>;
+constexpr SelectInByteTable MakeSelectInByteTable() {
+  SelectInByteTable table{};
+  for (int byte = 0; byte < 256; ++byte) {
+    int k = 0;
+    for (int bit = 0; bit < 8; ++bit) {
+      if (byte & (1 << bit)) table[byte][k++] = bit;
+    }
+  }
+  return table;
+}
+constexpr SelectInByteTable kSelectInByte = MakeSelectInByteTable();
+
+// Position of the k'th set bit of `word`. Finds the right byte with a few
+// word-wide operations instead of a loop, then looks it up in the table.
+int SelectInWord(uint64_t word, int k) {
+  constexpr uint64_t kOnes = 0x0101010101010101;
+  // The number of set bits in each byte, then the running total of those, so
+  // byte i of `prefix` is how many bits are set in bytes 0..i.
+  uint64_t counts = word - ((word >> 1) & 0x5555555555555555);
+  counts = (counts & 0x3333333333333333) + ((counts >> 2) & 0x3333333333333333);
+  counts = (counts + (counts >> 4)) & 0x0f0f0f0f0f0f0f0f;
+  const uint64_t prefix = counts * kOnes;
+  // Sets the top bit of each byte whose running total is more than k. Each
+  // byte of prefix is at most 64, so with its top bit set the subtraction
+  // never borrows from the next byte.
+  const uint64_t more_than_k =
+      ((prefix | (kOnes * 0x80)) - kOnes * (k + 1)) & (kOnes * 0x80);
+  const int byte = __builtin_ctzll(more_than_k) / 8;
+  const int before = static_cast<int>(((prefix << 8) >> (8 * byte)) & 0xff);
+  return byte * 8 + kSelectInByte[(word >> (8 * byte)) & 0xff][k - before];
+}
+
+}  // namespace
+
+BitVector::BitVector(size_t size, bool value)
+    : words_((size + 63) / 64, value ? ~uint64_t{0} : 0), size_(size) {
+  ClearBitsPastEnd();
+}
+
+void BitVector::resize(size_t size, bool value) {
+  if (value && size > size_ && size_ % 64 != 0) {
+    words_.back() |= ~uint64_t{0} << (size_ % 64);
+  }
+  words_.resize((size + 63) / 64, value ? ~uint64_t{0} : 0);
+  size_ = size;
+  ClearBitsPastEnd();
+  has_rank_select_ = false;
+}
+
+void BitVector::ClearBitsPastEnd() {
+  if (size_ % 64 != 0) words_.back() &= (uint64_t{1} << (size_ % 64)) - 1;
+}
+
+size_t BitVector::count() const {
+  if (has_rank_select_) return num_ones_;
+  return Ops().count(words_.data(), words_.size());
+}
+
+void BitVector::BuildRankSelect() {
+  const size_t num_blocks = words_.size() / kWordsPerBlock + 1;
+  rank_index_.resize(2 * num_blocks);
+  num_ones_ = Ops().build_index(words_.data(), words_.size(), num_blocks,
+                                rank_index_.data());
+
+  // A block holds at most 512 set bits and the samples are further apart
+  // than that, so each block gets at most one.
+  select_samples_.clear();
+  select_samples_.reserve(num_ones_ / kSelectSample + 1);
+  size_t next_sample = 0;
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t end =
+        block + 1 < num_blocks ? rank_index_[2 * (block + 1)] : num_ones_;
+    if (next_sample < end) {
+      select_samples_.push_back(static_cast<uint32_t>(block));
+      next_sample += kSelectSample;
+    }
+  }
+  has_rank_select_ = true;
+}
+
+size_t BitVector::Rank(size_t pos) const {
+  assert(has_rank_select_ && "Call BuildRankSelect() first");
+  assert(pos <= size_ && "BitVector index out of range");
+  return Ops().rank(words_.data(), rank_index_.data(), pos);
+}
+
+size_t BitVector::Select(size_t k) const {
+  assert(has_rank_select_ && "Call BuildRankSelect() first");
+  assert(k < num_ones_ && "Select past the last set bit");
+  // Binary search for the block holding set bit k, between the sampled block
+  // for k and the block after the next sample. Throughout, block `low` starts
+  // at or before bit k and block `high` starts after it (or is the end).
+  const size_t sample = k / kSelectSample;
+  size_t low = select_samples_[sample];
+  size_t high = sample + 1 < select_samples_.size()
+                    ? select_samples_[sample + 1] + 1
+                    : rank_index_.size() / 2;
+  while (high - low > 1) {
+    const size_t middle = low + (high - low) / 2;
+    if (rank_index_[2 * middle] <= k) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  // Then the word inside the block: the number of words whose running count
+  // is still <= k.
+  size_t rest = k - rank_index_[2 * low];
+  const uint64_t sub_counts = rank_index_[2 * low + 1];
+  size_t word_in_block = 0;
+  size_t before_word = 0;
+  for (size_t j = 1; j < kWordsPerBlock; ++j) {
+    const size_t before = (sub_counts >> (9 * (j - 1))) & 0x1ff;
+    if (before > rest) break;
+    word_in_block = j;
+    before_word = before;
+  }
+  rest -= before_word;
+  const size_t word = low * kWordsPerBlock + word_in_block;
+  return word * 64 + SelectInWord(words_[word], static_cast<int>(rest));
+}
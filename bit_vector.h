@@ -0,0 +1,217 @@
+#ifndef BIT_VECTOR_H_
+#define BIT_VECTOR_H_
+
+// BitVector is a packed array of bits, like std::vector<bool>, that can also
+// answer two questions quickly once you call BuildRankSelect():
+//
+//   Rank(pos)   how many bits before `pos` are set.
+//   Select(k)   where the k'th set bit is (counting from 0).
+//
+// That makes it a compact replacement for the int_set from Trees() when the
+// ints come from a known range: bit x is set if x is in the set. Membership
+// is test(x), Rank(x) is how many members are smaller than x, and Select(k)
+// is the k'th smallest member. std::set needs about 40 bytes per member and
+// has to walk the tree (or worse, std::distance) for the last two. This
+// needs one bit per possible value plus about 25% more for the index.
+//
+//   BitVector members(1'000'000);
+//   members.set(7);
+//   members.set(777);
+//   members.BuildRankSelect();
+//   members.Rank(100);   // 1
+//   members.Select(1);   // 777
+//   for (size_t x : members.Ones()) ...
+//
+// How it works: the bits are stored in 64-bit words, and every 512 bits (8
+// words, one cache line) gets two more words of index. One holds the number
+// of set bits before that block, the other packs the counts before each of
+// the block's words into 9-bit fields. Rank is those two lookups plus one
+// popcount, no matter how big the vector is. Select keeps the block of every
+// 4096th set bit, binary searches the blocks between two of those, and then
+// finds the bit inside the word. That's constant time when the set bits are
+// spread out and only gets slower (logarithmically) in long empty stretches.
+//
+// The index is a snapshot. Changing any bit throws it away, and calling
+// Rank() or Select() before building it again is a bug that debug builds
+// catch with assert().
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+
+class BitVector {
+ public:
+  BitVector() = default;
+  explicit BitVector(size_t size, bool value = false);
+
+  BitVector(const BitVector&) = default;
+  BitVector& operator=(const BitVector&) = default;
+  // Leaves `other` empty, not just with empty vectors inside.
+  BitVector(BitVector&& other) noexcept { *this = std::move(other); }
+  BitVector& operator=(BitVector&& other) noexcept {
+    words_ = std::move(other.words_);
+    rank_index_ = std::move(other.rank_index_);
+    select_samples_ = std::move(other.select_samples_);
+    size_ = std::exchange(other.size_, 0);
+    num_ones_ = std::exchange(other.num_ones_, 0);
+    has_rank_select_ = std::exchange(other.has_rank_select_, false);
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  bool test(size_t pos) const {
+    assert(pos < size_ && "BitVector index out of range");
+    return (words_[pos / 64] >> (pos % 64)) & 1;
+  }
+  bool operator[](size_t pos) const { return test(pos); }
+
+  void set(size_t pos, bool value = true) {
+    assert(pos < size_ && "BitVector index out of range");
+    const uint64_t bit = uint64_t{1} << (pos % 64);
+    if (value) {
+      words_[pos / 64] |= bit;
+    } else {
+      words_[pos / 64] &= ~bit;
+    }
+    has_rank_select_ = false;
+  }
+  void reset(size_t pos) { set(pos, false); }
+
+  void push_back(bool value) {
+    if (size_ % 64 == 0) words_.push_back(0);
+    ++size_;
+    set(size_ - 1, value);
+  }
+
+  // Growing sets the new bits to `value`.
+  void resize(size_t size, bool value = false);
+  void clear() { resize(0); }
+
+  // How many bits are set. Fast once the index is built, a pass over all the
+  // words otherwise.
+  size_t count() const;
+
+  // Builds the index Rank() and Select() need. O(size()), and it has to be
+  // called again after any change.
+  void BuildRankSelect();
+  bool has_rank_select() const { return has_rank_select_; }
+
+  // Number of set bits in [0, pos). pos can be anything up to size().
+  size_t Rank(size_t pos) const;
+  // Number of clear bits in [0, pos).
+  size_t Rank0(size_t pos) const { return pos - Rank(pos); }
+  // Position of the k'th set bit, counting from 0. k has to be less than
+  // count().
+  size_t Select(size_t k) const;
+
+  // The raw bits, 64 per word with bit i in word i / 64 at (i % 64). Bits
+  // past size() in the last word are always 0.
+  absl::Span<const uint64_t> words() const { return words_; }
+
+  // Bytes of heap memory used, bits and index.
+  size_t bytes_used() const {
+    return (words_.capacity() + rank_index_.capacity()) * sizeof(uint64_t) +
+           select_samples_.capacity() * sizeof(uint32_t);
+  }
+
+  // Iterates over the positions of the set bits in increasing order. It
+  // works a word at a time, skipping whole words of zeros and jumping
+  // straight to the next set bit inside a word, so it's much faster than
+  // calling test() on every position of a sparse vector.
+  class OnesIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const size_t*;
+    using reference = size_t;
+
+    OnesIterator() = default;
+
+    size_t operator*() const {
+      return word_index_ * 64 + __builtin_ctzll(current_);
+    }
+    OnesIterator& operator++() {
+      current_ &= current_ - 1;
+      SkipZeroWords();
+      return *this;
+    }
+    OnesIterator operator++(int) {
+      OnesIterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const OnesIterator& a, const OnesIterator& b) {
+      return a.word_index_ == b.word_index_ && a.current_ == b.current_;
+    }
+    friend bool operator!=(const OnesIterator& a, const OnesIterator& b) {
+      return !(a == b);
+    }
+
+   private:
+    friend class BitVector;
+
+    OnesIterator(const uint64_t* words, size_t word_index, size_t num_words)
+        : words_(words), word_index_(word_index), num_words_(num_words) {
+      if (word_index_ < num_words_) {
+        current_ = words_[word_index_];
+        SkipZeroWords();
+      }
+    }
+
+    void SkipZeroWords() {
+      while (current_ == 0 && ++word_index_ < num_words_) {
+        current_ = words_[word_index_];
+      }
+    }
+
+    const uint64_t* words_ = nullptr;
+    size_t word_index_ = 0;
+    size_t num_words_ = 0;
+    // What's left of words_[word_index_]: the bits already visited are
+    // cleared.
+    uint64_t current_ = 0;
+  };
+
+  struct OnesRange {
+    OnesIterator first;
+    OnesIterator last;
+    OnesIterator begin() const { return first; }
+    OnesIterator end() const { return last; }
+  };
+  OnesRange Ones() const {
+    return {OnesIterator(words_.data(), 0, words_.size()),
+            OnesIterator(words_.data(), words_.size(), words_.size())};
+  }
+
+ private:
+  void ClearBitsPastEnd();
+
+  // Select() remembers the block of every kSelectSample'th set bit.
+  static constexpr size_t kSelectSample = 4096;
+
+  // Exactly (size_ + 63) / 64 words.
+  std::vector<uint64_t> words_;
+  size_t size_ = 0;
+
+  // Two words per block of 8 words, plus one more block at the end so
+  // Rank(size()) doesn't need a special case. rank_index_[2 * b] is the
+  // number of set bits before block b, and bits 9 * (j - 1) .. 9 * j - 1 of
+  // rank_index_[2 * b + 1] are how many bits are set in the block's first j
+  // words, for j = 1..7.
+  std::vector<uint64_t> rank_index_;
+  // select_samples_[i] is the block holding set bit number i * kSelectSample.
+  std::vector<uint32_t> select_samples_;
+  size_t num_ones_ = 0;
+  bool has_rank_select_ = false;
+};
+
+#endif  // BIT_VECTOR_H_
@@ -0,0 +1,208 @@
+// BitVector against std::vector<bool> and the int_set from Trees(), all
+// holding the same set of ints drawn from [0, universe). Run with:
+//   bazel run -c opt :bit_vector_bench
+//
+// The first argument is the universe size and the second how many percent of
+// it are members. bytes_per_member is the memory each one takes per member:
+// std::set pays ~40 bytes no matter what, the bit vectors pay for every
+// possible value, so they win by a mile when the set is dense and lose when
+// it's very sparse.
+//
+// Rank (how many members are smaller than x) is linear in std::vector<bool>
+// and std::set, so those only run at the smaller sizes.
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "benchmark/benchmark.h"
+#include "bit_vector.h"
+
+namespace {
+
+constexpr int64_t kUniverses[] = {1 << 16, 1 << 20, 1 << 24};
+constexpr int kDensityPercents[] = {1, 50};
+// Queries cycle through this many random values.
+constexpr int kNumQueries = 4096;
+
+// Sorted, no duplicates.
+std::vector<int> MakeMembers(int64_t universe, int density_percent) {
+  std::mt19937 rng(universe + density_percent);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::vector<int> members;
+  for (int x = 0; x < universe; ++x) {
+    if (percent(rng) < density_percent) members.push_back(x);
+  }
+  return members;
+}
+
+std::vector<int> MakeQueries(int64_t max_value) {
+  std::mt19937 rng(max_value);
+  std::uniform_int_distribution<int> value(0, max_value - 1);
+  std::vector<int> queries(kNumQueries);
+  for (int& x : queries) x = value(rng);
+  return queries;
+}
+
+// The same few operations on each of the three ways of storing the set.
+
+struct VectorBoolSet {
+  VectorBoolSet(const std::vector<int>& members, int64_t universe)
+      : bits(universe) {
+    for (int x : members) bits[x] = true;
+  }
+  bool Contains(int x) const { return bits[x]; }
+  size_t Rank(int x) const {
+    return std::count(bits.begin(), bits.begin() + x, true);
+  }
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    for (size_t i = 0; i < bits.size(); ++i) {
+      if (bits[i]) fn(i);
+    }
+  }
+
+  std::vector<bool> bits;
+};
+
+struct IntSet {
+  IntSet(const std::vector<int>& members, int64_t) {
+    for (int x : members) int_set.insert(int_set.end(), x);
+  }
+  bool Contains(int x) const { return int_set.count(x) != 0; }
+  size_t Rank(int x) const {
+    return std::distance(int_set.begin(), int_set.lower_bound(x));
+  }
+  size_t Select(size_t k) const { return *std::next(int_set.begin(), k); }
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    for (int x : int_set) fn(x);
+  }
+
+  std::set<int> int_set;
+};
+
+struct BitVectorSet {
+  BitVectorSet(const std::vector<int>& members, int64_t universe)
+      : bits(universe) {
+    for (int x : members) bits.set(x);
+    bits.BuildRankSelect();
+  }
+  bool Contains(int x) const { return bits.test(x); }
+  size_t Rank(int x) const { return bits.Rank(x); }
+  size_t Select(size_t k) const { return bits.Select(k); }
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    for (size_t x : bits.Ones()) fn(x);
+  }
+
+  BitVector bits;
+};
+
+// Builds the set for this benchmark's arguments and reports how much memory
+// it took per member.
+template <typename Set>
+struct Fixture {
+  explicit Fixture(benchmark::State& state)
+      : universe(state.range(0)),
+        members(MakeMembers(universe, state.range(1))) {
+    const AllocStats before = GetAllocStats();
+    set = std::make_unique<Set>(members, universe);
+    state.counters["bytes_per_member"] =
+        static_cast<double>(GetAllocStats().live_bytes - before.live_bytes) /
+        std::max<size_t>(members.size(), 1);
+  }
+
+  int64_t universe;
+  std::vector<int> members;
+  std::unique_ptr<Set> set;
+};
+
+template <typename Set>
+void BM_Contains(benchmark::State& state) {
+  Fixture<Set> fixture(state);
+  const std::vector<int> queries = MakeQueries(fixture.universe);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        fixture.set->Contains(queries[i++ % kNumQueries]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Set>
+void BM_Rank(benchmark::State& state) {
+  Fixture<Set> fixture(state);
+  const std::vector<int> queries = MakeQueries(fixture.universe);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fixture.set->Rank(queries[i++ % kNumQueries]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The k'th smallest member, for random k.
+template <typename Set>
+void BM_Select(benchmark::State& state) {
+  Fixture<Set> fixture(state);
+  if (fixture.members.empty()) {
+    state.SkipWithError("no members");
+    return;
+  }
+  const std::vector<int> queries = MakeQueries(fixture.members.size());
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fixture.set->Select(queries[i++ % kNumQueries]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Visits every member in order.
+template <typename Set>
+void BM_Scan(benchmark::State& state) {
+  Fixture<Set> fixture(state);
+  for (auto _ : state) {
+    size_t sum = 0;
+    fixture.set->ForEach([&sum](size_t x) { sum += x; });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * fixture.members.size());
+}
+
+void AllSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t universe : kUniverses) {
+    for (int density : kDensityPercents) b->Args({universe, density});
+  }
+}
+
+// For the operations that are linear in the baselines.
+void SmallSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t universe : kUniverses) {
+    if (universe > (1 << 20)) continue;
+    for (int density : kDensityPercents) b->Args({universe, density});
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Contains, VectorBoolSet)->Apply(AllSizes);
+BENCHMARK_TEMPLATE(BM_Contains, IntSet)->Apply(AllSizes);
+BENCHMARK_TEMPLATE(BM_Contains, BitVectorSet)->Apply(AllSizes);
+
+BENCHMARK_TEMPLATE(BM_Rank, VectorBoolSet)->Apply(SmallSizes);
+BENCHMARK_TEMPLATE(BM_Rank, IntSet)->Apply(SmallSizes);
+BENCHMARK_TEMPLATE(BM_Rank, BitVectorSet)->Apply(AllSizes);
+
+BENCHMARK_TEMPLATE(BM_Select, IntSet)->Apply(SmallSizes);
+BENCHMARK_TEMPLATE(BM_Select, BitVectorSet)->Apply(AllSizes);
+
+BENCHMARK_TEMPLATE(BM_Scan, VectorBoolSet)->Apply(AllSizes);
+BENCHMARK_TEMPLATE(BM_Scan, IntSet)->Apply(AllSizes);
+BENCHMARK_TEMPLATE(BM_Scan, BitVectorSet)->Apply(AllSizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+#ifndef CHASE_LEV_DEQUE_H_
+#define CHASE_LEV_DEQUE_H_
+
+// ChaseLevDeque<T> is the work-stealing deque every work-stealing scheduler
+// is built around. One thread owns it and pushes and pops at the bottom, like
+// a stack. Any other thread can steal from the top. The owner's push and pop
+// are almost as cheap as a vector's push_back/pop_back, and only touch shared
+// state with a compare and swap when the deque is down to its last element.
+//
+// The owner working off the bottom means it runs the work it spawned most
+// recently first, which is still hot in its cache. Thieves take the oldest
+// work from the top, which in a divide and conquer algorithm is the biggest
+// chunk, so a steal tends to be worth it.
+//
+// This is the version from Lê, Pop, Cohen and Zappa Nardelli, "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013), which spells
+// out which atomics need which memory orders.
+//
+// T has to be trivially copyable, since elements are read by thieves that
+// might lose the race for them. In practice it's a pointer to a task.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+class ChaseLevDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Store pointers to your tasks instead.");
+
+ public:
+  explicit ChaseLevDeque(int64_t initial_capacity = 256) {
+    int64_t capacity = 1;
+    while (capacity < initial_capacity) capacity <<= 1;
+    arrays_.push_back(std::make_unique<Array>(capacity));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+
+  ChaseLevDeque(const ChaseLevDeque&) = delete;
+  ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+  // Owner only. Grows if it's full, so it always succeeds.
+  void Push(T value) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    Array* array = array_.load(std::memory_order_relaxed);
+    if (bottom - top > array->mask) array = Grow(array, top, bottom);
+    array->Put(bottom, value);
+    // The paper has a release fence and then a relaxed store, which is the
+    // same thing as far as thieves are concerned, but ThreadSanitizer only
+    // understands this version.
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Owner only. Takes the most recently pushed element. Returns false if the
+  // deque is empty, or if a thief got the last element first.
+  bool Pop(T& out) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      // Was already empty.
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+    out = array->Get(bottom);
+    if (top == bottom) {
+      // The last element. Race any thieves for it.
+      bool won = top_.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed);
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Takes the oldest element. Returns false if the deque is
+  // empty or another thread won the race for it; either way, go try
+  // somewhere else.
+  bool Steal(T& out) {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) return false;
+    // The paper uses memory_order_consume here, which every compiler treats
+    // as acquire anyway.
+    Array* array = array_.load(std::memory_order_acquire);
+    T value = array->Get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    out = value;
+    return true;
+  }
+
+  // Only a snapshot, since other threads can change it right after.
+  int64_t size_approx() const {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? bottom - top : 0;
+  }
+
+ private:
+  // A circular buffer. Elements are atomics so a thief reading a slot the
+  // owner is overwriting isn't a data race, just a value it'll throw away.
+  struct Array {
+    explicit Array(int64_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+    T Get(int64_t i) const {
+      return slots[i & mask].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t i, T value) {
+      slots[i & mask].store(value, std::memory_order_relaxed);
+    }
+
+    const int64_t mask;
+    std::unique_ptr<std::atomic<T>[]> slots;
+  };
+
+  Array* Grow(Array* old_array, int64_t top, int64_t bottom) {
+    auto array = std::make_unique<Array>(2 * (old_array->mask + 1));
+    for (int64_t i = top; i < bottom; ++i) array->Put(i, old_array->Get(i));
+    // Thieves may still be reading the old array, so it can't be freed until
+    // the deque is. They only ever double, so all the old ones together are
+    // never bigger than the current one.
+    arrays_.push_back(std::move(array));
+    Array* result = arrays_.back().get();
+    array_.store(result, std::memory_order_release);
+    return result;
+  }
+
+  // Thieves write top_ and the owner writes bottom_, so keep them on separate
+  // cache lines. See SpscQueue for why this is hardcoded.
+  static constexpr size_t kCacheLineSize = 64;
+  alignas(kCacheLineSize) std::atomic<int64_t> top_{0};
+  alignas(kCacheLineSize) std::atomic<int64_t> bottom_{0};
+  std::atomic<Array*> array_;
+  // Owned by the owner thread: every array ever used.
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+#endif  // CHASE_LEV_DEQUE_H_
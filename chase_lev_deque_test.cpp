@@ -0,0 +1,95 @@
+#include "chase_lev_deque.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(ChaseLevDequeTest, OwnerPopsNewestThiefStealsOldest) {
+  ChaseLevDeque<int> deque(4);
+  int x;
+  EXPECT_FALSE(deque.Pop(x));
+  EXPECT_FALSE(deque.Steal(x));
+  for (int i = 0; i < 4; ++i) deque.Push(i);
+  EXPECT_EQ(deque.size_approx(), 4);
+  ASSERT_TRUE(deque.Pop(x));
+  EXPECT_EQ(x, 3);
+  ASSERT_TRUE(deque.Steal(x));
+  EXPECT_EQ(x, 0);
+  ASSERT_TRUE(deque.Pop(x));
+  EXPECT_EQ(x, 2);
+  ASSERT_TRUE(deque.Pop(x));
+  EXPECT_EQ(x, 1);
+  EXPECT_FALSE(deque.Pop(x));
+  EXPECT_FALSE(deque.Steal(x));
+  EXPECT_EQ(deque.size_approx(), 0);
+}
+
+// Starting at 2 and wrapping around first, so growing has to copy elements
+// that straddle the end of the old buffer.
+TEST(ChaseLevDequeTest, GrowsAndKeepsEverything) {
+  ChaseLevDeque<int> deque(2);
+  int x;
+  for (int i = 0; i < 3; ++i) {
+    deque.Push(-1);
+    ASSERT_TRUE(deque.Steal(x));
+  }
+  for (int i = 0; i < 1000; ++i) deque.Push(i);
+  EXPECT_EQ(deque.size_approx(), 1000);
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_TRUE(deque.Steal(x));
+    EXPECT_EQ(x, i);
+  }
+  for (int i = 999; i >= 500; --i) {
+    ASSERT_TRUE(deque.Pop(x));
+    EXPECT_EQ(x, i);
+  }
+  EXPECT_FALSE(deque.Pop(x));
+}
+
+// The owner pushes, and now and then pops, while thieves steal. Starting
+// small makes it grow while they're at it. Every item has to be taken exactly
+// once, by someone.
+TEST(ChaseLevDequeTest, EveryItemTakenOnce) {
+  constexpr int kNumItems = 200'000;
+  constexpr int kThieves = 3;
+  ChaseLevDeque<int> deque(2);
+  std::vector<std::atomic<int>> taken(kNumItems);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < kThieves; ++t) {
+    thieves.emplace_back([&] {
+      int x;
+      while (!done.load(std::memory_order_acquire)) {
+        if (deque.Steal(x)) {
+          taken[x].fetch_add(1, std::memory_order_relaxed);
+        } else {
+          // Let the owner run on machines with fewer cores than threads.
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  int x;
+  for (int i = 0; i < kNumItems; ++i) {
+    deque.Push(i);
+    if (i % 3 == 0 && deque.Pop(x)) {
+      taken[x].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  while (deque.size_approx() > 0) {
+    if (deque.Pop(x)) taken[x].fetch_add(1, std::memory_order_relaxed);
+  }
+  done.store(true, std::memory_order_release);
+  for (std::thread& thief : thieves) thief.join();
+
+  for (const std::atomic<int>& count : taken) ASSERT_EQ(count.load(), 1);
+}
+
+}  // namespace
@@ -0,0 +1,455 @@
+#ifndef CHUNKED_DEQUE_H_
+#define CHUNKED_DEQUE_H_
+
+// ChunkedDeque<T, BlockBytes> is a std::deque where you get to pick the block
+// size.
+//
+// A deque stores its elements in fixed-size blocks plus a small array of
+// pointers to the blocks (the "map"), which is how it gets O(1) push and pop
+// at both ends without ever moving elements. How big the blocks are is up to
+// the standard library, and libstdc++ uses 512 bytes. For something like
+// Person that's only a dozen elements per block, so a queue of them is mostly
+// allocating and freeing blocks and chasing map pointers. ChunkedDeque blocks
+// are BlockBytes (4 KB by default) and it also keeps a few empty blocks around
+// to reuse, so a queue that stays about the same size stops allocating
+// altogether.
+//
+// It has everything std::queue and std::stack need, so it drops in as their
+// container:
+//
+//   std::queue<Person, ChunkedDeque<Person>> people;
+//   ChunkedDeque<Person, 64 * 1024> big_blocks;
+//
+// Iterators are random access, and like std::deque's, pushing or popping
+// invalidates them. For scans, ForEachBlock() hands you each block's elements
+// as one contiguous array, so the inner loop is a plain loop over an array.
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T, size_t BlockBytes = 4096>
+class ChunkedDeque {
+ public:
+  // Elements per block. At least one, for Ts bigger than BlockBytes.
+  static constexpr size_t kBlockSize =
+      std::max<size_t>(1, BlockBytes / sizeof(T));
+
+ private:
+  template <bool kConst>
+  class Iterator;
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  ChunkedDeque() noexcept = default;
+  ChunkedDeque(std::initializer_list<T> init) {
+    for (const T& value : init) push_back(value);
+  }
+  ChunkedDeque(const ChunkedDeque& other) {
+    other.ForEachBlock([this](const T* data, size_t count) {
+      for (size_t i = 0; i < count; ++i) push_back(data[i]);
+    });
+  }
+  ChunkedDeque(ChunkedDeque&& other) noexcept { swap(other); }
+  ~ChunkedDeque() {
+    clear();
+    for (T* block : spare_blocks_) FreeBlock(block);
+  }
+
+  ChunkedDeque& operator=(const ChunkedDeque& other) {
+    if (this != &other) {
+      ChunkedDeque copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+  ChunkedDeque& operator=(ChunkedDeque&& other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  reference operator[](size_type pos) { return *Slot(pos); }
+  const_reference operator[](size_type pos) const { return *Slot(pos); }
+  reference at(size_type pos) {
+    if (pos >= size_) throw std::out_of_range("ChunkedDeque::at");
+    return *Slot(pos);
+  }
+  const_reference at(size_type pos) const {
+    if (pos >= size_) throw std::out_of_range("ChunkedDeque::at");
+    return *Slot(pos);
+  }
+  reference front() { return *Slot(0); }
+  const_reference front() const { return *Slot(0); }
+  reference back() { return *Slot(size_ - 1); }
+  const_reference back() const { return *Slot(size_ - 1); }
+
+  iterator begin() noexcept { return iterator(this, 0); }
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(this, size_); }
+  const_iterator end() const noexcept { return const_iterator(this, size_); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    const size_t end = begin_ + size_;
+    if (end < num_blocks_ * kBlockSize) {
+      T* slot = ::new (static_cast<void*>(Slot(size_)))
+          T(std::forward<Args>(args)...);
+      ++size_;
+      return *slot;
+    }
+    // The last block is full (or there isn't one). Only link the new block in
+    // once the element is constructed, so nothing changes if that throws.
+    ReserveMapSlot();
+    T* block = AcquireBlock();
+    try {
+      ::new (static_cast<void*>(block)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      ReleaseBlock(block);
+      throw;
+    }
+    map_[(first_block_ + num_blocks_) & (map_.size() - 1)] = block;
+    ++num_blocks_;
+    ++size_;
+    return *block;
+  }
+
+  template <typename... Args>
+  reference emplace_front(Args&&... args) {
+    if (begin_ > 0) {
+      T* slot = ::new (static_cast<void*>(BlockStart(0) + begin_ - 1))
+          T(std::forward<Args>(args)...);
+      --begin_;
+      ++size_;
+      return *slot;
+    }
+    // The new element goes at the end of a new first block.
+    ReserveMapSlot();
+    T* block = AcquireBlock();
+    T* slot = block + kBlockSize - 1;
+    try {
+      ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      ReleaseBlock(block);
+      throw;
+    }
+    first_block_ = (first_block_ - 1) & (map_.size() - 1);
+    map_[first_block_] = block;
+    ++num_blocks_;
+    begin_ = kBlockSize - 1;
+    ++size_;
+    return *slot;
+  }
+
+  void pop_front() {
+    std::destroy_at(Slot(0));
+    ++begin_;
+    --size_;
+    if (begin_ == kBlockSize) {
+      // Used up the first block.
+      ReleaseBlock(map_[first_block_]);
+      first_block_ = (first_block_ + 1) & (map_.size() - 1);
+      --num_blocks_;
+      begin_ = 0;
+    }
+  }
+
+  void pop_back() {
+    --size_;
+    std::destroy_at(Slot(size_));
+    if (begin_ + size_ == (num_blocks_ - 1) * kBlockSize) {
+      // That was the only element in the last block.
+      ReleaseBlock(BlockStart(num_blocks_ - 1));
+      --num_blocks_;
+    }
+  }
+
+  void clear() noexcept {
+    ForEachBlock([](T* data, size_t count) { std::destroy_n(data, count); });
+    for (size_t i = 0; i < num_blocks_; ++i) ReleaseBlock(BlockStart(i));
+    first_block_ = 0;
+    num_blocks_ = 0;
+    begin_ = 0;
+    size_ = 0;
+  }
+
+  void swap(ChunkedDeque& other) noexcept {
+    map_.swap(other.map_);
+    spare_blocks_.swap(other.spare_blocks_);
+    std::swap(first_block_, other.first_block_);
+    std::swap(num_blocks_, other.num_blocks_);
+    std::swap(begin_, other.begin_);
+    std::swap(size_, other.size_);
+  }
+
+  // Frees the spare blocks kept around for reuse.
+  void shrink_to_fit() {
+    for (T* block : spare_blocks_) FreeBlock(block);
+    spare_blocks_.clear();
+    spare_blocks_.shrink_to_fit();
+  }
+
+  // Calls fn(data, count) for each block in order, where data[0..count) are
+  // that block's elements.
+  template <typename Fn>
+  void ForEachBlock(Fn&& fn) {
+    ForEachBlockImpl<T>(*this, fn);
+  }
+  template <typename Fn>
+  void ForEachBlock(Fn&& fn) const {
+    ForEachBlockImpl<const T>(*this, fn);
+  }
+
+ private:
+  // How many empty blocks to keep for reuse. Enough to absorb a burst without
+  // going back to the allocator.
+  static constexpr size_t kMaxSpareBlocks = 8;
+
+  template <bool kConst>
+  class Iterator {
+    using Deque = std::conditional_t<kConst, const ChunkedDeque, ChunkedDeque>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<kConst, const T*, T*>;
+    using reference = std::conditional_t<kConst, const T&, T&>;
+
+    Iterator() = default;
+    Iterator(Deque* deque, size_t index) : deque_(deque), index_(index) {
+      FindBlock();
+    }
+    // iterator converts to const_iterator, not the other way around.
+    template <bool kOtherConst,
+              typename = std::enable_if_t<kConst && !kOtherConst>>
+    Iterator(const Iterator<kOtherConst>& other)
+        : deque_(other.deque_),
+          index_(other.index_),
+          cur_(other.cur_),
+          block_begin_(other.block_begin_),
+          block_end_(other.block_end_) {}
+
+    reference operator*() const { return *cur_; }
+    pointer operator->() const { return cur_; }
+    reference operator[](difference_type n) const {
+      return *deque_->Slot(index_ + n);
+    }
+
+    // Stepping within a block is just a pointer increment. Only moving to
+    // another block has to look it up in the map.
+    Iterator& operator++() {
+      ++index_;
+      if (++cur_ == block_end_) FindBlock();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+    Iterator& operator--() {
+      --index_;
+      if (cur_ == block_begin_) {
+        FindBlock();
+      } else {
+        --cur_;
+      }
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --*this;
+      return old;
+    }
+    Iterator& operator+=(difference_type n) {
+      index_ += n;
+      FindBlock();
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index_ -= n;
+      FindBlock();
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator& a, const Iterator& b) {
+      return static_cast<difference_type>(a.index_) -
+             static_cast<difference_type>(b.index_);
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.index_ == b.index_;
+    }
+    friend bool operator!=(const Iterator& a, const Iterator& b) {
+      return a.index_ != b.index_;
+    }
+    friend bool operator<(const Iterator& a, const Iterator& b) {
+      return a.index_ < b.index_;
+    }
+    friend bool operator>(const Iterator& a, const Iterator& b) {
+      return a.index_ > b.index_;
+    }
+    friend bool operator<=(const Iterator& a, const Iterator& b) {
+      return a.index_ <= b.index_;
+    }
+    friend bool operator>=(const Iterator& a, const Iterator& b) {
+      return a.index_ >= b.index_;
+    }
+
+   private:
+    template <bool>
+    friend class Iterator;
+
+    // Points cur_ at element index_, or at nothing for end().
+    void FindBlock() {
+      if (index_ < deque_->size_) {
+        size_t p = deque_->begin_ + index_;
+        block_begin_ = deque_->BlockStart(p / kBlockSize);
+        block_end_ = block_begin_ + kBlockSize;
+        cur_ = block_begin_ + p % kBlockSize;
+      } else {
+        cur_ = block_begin_ = block_end_ = nullptr;
+      }
+    }
+
+    Deque* deque_ = nullptr;
+    // Compared and subtracted by index, since end() has no element to point
+    // at.
+    size_t index_ = 0;
+    pointer cur_ = nullptr;
+    pointer block_begin_ = nullptr;
+    pointer block_end_ = nullptr;
+  };
+
+  template <typename U, typename Self, typename Fn>
+  static void ForEachBlockImpl(Self& self, Fn& fn) {
+    size_t remaining = self.size_;
+    size_t offset = self.begin_;
+    for (size_t i = 0; remaining > 0; ++i) {
+      size_t count = std::min(remaining, kBlockSize - offset);
+      U* data = self.BlockStart(i) + offset;
+      fn(data, count);
+      remaining -= count;
+      offset = 0;
+    }
+  }
+
+  // The i-th block in use, counting from the front.
+  T* BlockStart(size_t i) const {
+    return map_[(first_block_ + i) & (map_.size() - 1)];
+  }
+
+  // Where element `pos` lives.
+  T* Slot(size_t pos) const {
+    size_t p = begin_ + pos;
+    return BlockStart(p / kBlockSize) + p % kBlockSize;
+  }
+
+  // Makes sure there's room in the map for one more block. The map is a
+  // circular buffer with a power of two size, so blocks can be added at
+  // either end without shifting the others.
+  void ReserveMapSlot() {
+    if (num_blocks_ < map_.size()) return;
+    std::vector<T*> map(std::max<size_t>(8, 2 * map_.size()));
+    for (size_t i = 0; i < num_blocks_; ++i) map[i] = BlockStart(i);
+    map_.swap(map);
+    first_block_ = 0;
+  }
+
+  T* AcquireBlock() {
+    if (spare_blocks_.empty()) {
+      return static_cast<T*>(::operator new(kBlockSize * sizeof(T),
+                                            std::align_val_t(alignof(T))));
+    }
+    T* block = spare_blocks_.back();
+    spare_blocks_.pop_back();
+    return block;
+  }
+
+  void ReleaseBlock(T* block) noexcept {
+    if (spare_blocks_.size() < kMaxSpareBlocks) {
+      // Reserve room for all of them the first time, so push_back can't
+      // throw after that.
+      if (spare_blocks_.capacity() < kMaxSpareBlocks) {
+        try {
+          spare_blocks_.reserve(kMaxSpareBlocks);
+        } catch (...) {
+          FreeBlock(block);
+          return;
+        }
+      }
+      spare_blocks_.push_back(block);
+    } else {
+      FreeBlock(block);
+    }
+  }
+
+  static void FreeBlock(T* block) noexcept {
+    ::operator delete(block, std::align_val_t(alignof(T)));
+  }
+
+  // Pointers to the blocks in use, as a circular buffer starting at
+  // first_block_.
+  std::vector<T*> map_;
+  size_t first_block_ = 0;
+  size_t num_blocks_ = 0;
+  // Index of the first element in the first block.
+  size_t begin_ = 0;
+  size_t size_ = 0;
+  std::vector<T*> spare_blocks_;
+};
+
+template <typename T, size_t BlockBytes>
+void swap(ChunkedDeque<T, BlockBytes>& a,
+          ChunkedDeque<T, BlockBytes>& b) noexcept {
+  a.swap(b);
+}
+
+#endif  // CHUNKED_DEQUE_H_
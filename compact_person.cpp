@@ -0,0 +1,16 @@
+#include "compact_person.h"
+
+#include <cassert>
+#include <limits>
+
+CompactPerson CompactPerson::FromPerson(const Person& person,
+                                       StringPool& pool) {
+  assert(person.age >= 0 && person.age <= std::numeric_limits<uint8_t>::max() &&
+         "CompactPerson ages have to fit in a uint8_t");
+  return CompactPerson{pool.Intern(person.name),
+                       static_cast<uint8_t>(person.age)};
+}
+
+Person CompactPerson::ToPerson(const StringPool& pool) const {
+  return Person{std::string(pool[name_id]), age};
+}
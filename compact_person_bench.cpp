@@ -0,0 +1,164 @@
+// Memory per element for Person vs CompactPerson in the containers from
+// main.cpp, and how long each takes to fill. Run with:
+//   bazel run -c opt :compact_person_bench
+//
+// The first argument is the number of people and the second how many
+// different names they have between them. bytes_per_element is all the heap
+// memory the container uses divided by how many elements it ended up with,
+// which for CompactPerson includes the StringPool. The sets are all ordered or
+// hashed by name like person_comp and hash_fn/eq_fn in main.cpp, since ages
+// alone would only make for 100 different elements.
+//
+// The names here fit in std::string's small string buffer. Longer ones cost
+// every Person a heap allocation on top of its 40 bytes, but cost the
+// StringPool only once per different name.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "compact_person.h"
+#include "person.h"
+
+namespace {
+
+std::vector<Person> MakeNamedPeople(int64_t n, int64_t num_names) {
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<int> age(0, 99);
+  ScrambledOrder order(n);
+  std::vector<Person> people;
+  people.reserve(n);
+  for (int64_t i = 0; i < n; ++i) {
+    people.push_back({MakeKey<std::string>(order[i] % num_names), age(rng)});
+  }
+  return people;
+}
+
+template <typename Container, typename T>
+void Add(Container& container, T&& value) {
+  container.insert(std::forward<T>(value));
+}
+template <typename T, typename U>
+void Add(std::vector<T>& container, U&& value) {
+  container.push_back(std::forward<U>(value));
+}
+
+void SetCounters(benchmark::State& state, int64_t bytes, size_t elements) {
+  state.counters["bytes_per_element"] =
+      static_cast<double>(bytes) / std::max<size_t>(elements, 1);
+  state.counters["elements"] = elements;
+}
+
+template <typename Container>
+void BM_BuildPerson(benchmark::State& state) {
+  const std::vector<Person> people =
+      MakeNamedPeople(state.range(0), state.range(1));
+  for (auto _ : state) {
+    {
+      const AllocStats before = GetAllocStats();
+      Container container;
+      for (const Person& person : people) Add(container, person);
+      state.PauseTiming();
+      SetCounters(state, GetAllocStats().live_bytes - before.live_bytes,
+                  container.size());
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// make_container(pool) makes an empty container, for the comparators that
+// need the pool.
+template <typename MakeContainer>
+void BM_BuildCompactPerson(benchmark::State& state,
+                           MakeContainer make_container) {
+  const std::vector<Person> people =
+      MakeNamedPeople(state.range(0), state.range(1));
+  for (auto _ : state) {
+    {
+      const AllocStats before = GetAllocStats();
+      auto pool = std::make_unique<StringPool>();
+      auto container = make_container(pool.get());
+      for (const Person& person : people) {
+        Add(container, CompactPerson::FromPerson(person, *pool));
+      }
+      state.PauseTiming();
+      SetCounters(state, GetAllocStats().live_bytes - before.live_bytes,
+                  container.size());
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+template <typename Container>
+auto Make() {
+  return [](const StringPool*) { return Container(); };
+}
+template <typename Container>
+auto MakeOrderedByName() {
+  return [](const StringPool* pool) {
+    return Container(CompactPersonNameLess(pool));
+  };
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  constexpr int64_t kNumPeople = 1 << 20;
+  for (int64_t num_names : {kNumPeople, kNumPeople / 16}) {
+    b->Args({kNumPeople, num_names});
+  }
+  b->Unit(benchmark::kMillisecond);
+}
+
+// Registers BM_Build/<name>/Person and BM_Build/<name>/CompactPerson.
+template <typename PersonContainer, typename MakeContainer>
+void RegisterPair(const std::string& name, MakeContainer make_container) {
+  benchmark::RegisterBenchmark(("BM_Build/" + name + "/Person").c_str(),
+                               BM_BuildPerson<PersonContainer>)
+      ->Apply(Sizes);
+  benchmark::RegisterBenchmark(
+      ("BM_Build/" + name + "/CompactPerson").c_str(),
+      BM_BuildCompactPerson<MakeContainer>, make_container)
+      ->Apply(Sizes);
+}
+
+void RegisterAll() {
+  RegisterPair<std::vector<Person>>("std::vector",
+                                    Make<std::vector<CompactPerson>>());
+  RegisterPair<std::set<Person, PersonNameLess>>(
+      "std::set",
+      MakeOrderedByName<std::set<CompactPerson, CompactPersonNameLess>>());
+  RegisterPair<absl::btree_set<Person, PersonNameLess>>(
+      "absl::btree_set",
+      MakeOrderedByName<
+          absl::btree_set<CompactPerson, CompactPersonNameLess>>());
+  RegisterPair<std::unordered_set<Person, PersonNameHash, PersonNameEq>>(
+      "std::unordered_set",
+      Make<std::unordered_set<CompactPerson, CompactPersonNameHash,
+                              CompactPersonNameEq>>());
+  RegisterPair<absl::flat_hash_set<Person, PersonNameHash, PersonNameEq>>(
+      "absl::flat_hash_set",
+      Make<absl::flat_hash_set<CompactPerson, CompactPersonNameHash,
+                               CompactPersonNameEq>>());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  RegisterAll();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,390 @@
+// Benchmarks insert, lookup, iterate and erase for every container used in
+// main.cpp, so the claims in the comments there can be checked against real
+// numbers. Run with:
+//   bazel run -c opt :container_bench -- --benchmark_filter=BTree
+// Sizes go from 10 up to 100M elements. The string and Person containers need
+// several GB of RAM at the top end, so filter those out on small machines.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <queue>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "person.h"
+
+namespace {
+
+// Lookups cycle through at most this many pre-made keys or indexes so that
+// building a std::string key, or scrambling an index, doesn't get counted as
+// part of the lookup.
+constexpr int64_t kMaxLookupKeys = 1 << 20;
+
+// Every container in main.cpp falls into one of the shapes below. Each "Ops"
+// struct knows how to fill, look up, iterate and erase one kind of container.
+// Not every container supports every operation (you can't iterate a
+// priority_queue), in which case that benchmark just isn't registered.
+
+// new int[] and unique_ptr<int[]>. "Insert" is allocating and writing every
+// slot since you can't grow these.
+struct RawArrayOps {
+  using Container = std::unique_ptr<int[]>;
+  static Container Fill(int64_t n) {
+    // Deliberately new[] and not make_unique, which would zero the memory
+    // first. This is the num_array example.
+    int* nums = new int[n];
+    for (int64_t i = 0; i < n; ++i) nums[i] = static_cast<int>(i);
+    return Container(nums);
+  }
+  static bool Lookup(const Container& c, int64_t i) { return c[i] != 0; }
+  static int64_t Iterate(const Container& c, int64_t n) {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < n; ++i) sum += c[i];
+    return sum;
+  }
+};
+
+struct UniquePtrArrayOps {
+  using Container = std::unique_ptr<int[]>;
+  static Container Fill(int64_t n) {
+    auto nums = std::make_unique<int[]>(n);
+    for (int64_t i = 0; i < n; ++i) nums[i] = static_cast<int>(i);
+    return nums;
+  }
+  static bool Lookup(const Container& c, int64_t i) { return c[i] != 0; }
+  static int64_t Iterate(const Container& c, int64_t n) {
+    return RawArrayOps::Iterate(c, n);
+  }
+};
+
+// std::vector grown one push_back at a time, with no reserve().
+template <typename T>
+struct VectorOps {
+  using Container = std::vector<T>;
+  static Container Fill(int64_t n) {
+    Container c;
+    for (int64_t i = 0; i < n; ++i) c.push_back(MakeKey<T>(i));
+    return c;
+  }
+  static bool Lookup(const Container& c, int64_t i) {
+    return c[i] == MakeKey<T>(0);
+  }
+  static int64_t Iterate(const Container& c, int64_t) {
+    int64_t sum = 0;
+    for (const T& t : c) sum += t;
+    return sum;
+  }
+  static void EraseAll(Container& c, int64_t n) {
+    for (int64_t i = 0; i < n; ++i) c.pop_back();
+  }
+};
+
+// std::array has to know its size at compile time, so it gets a fixed N
+// instead of the size sweep.
+template <size_t N>
+struct StdArrayOps {
+  using Container = std::unique_ptr<std::array<int, N>>;
+  static Container Fill(int64_t) {
+    // On the heap so the big ones don't blow the stack.
+    auto c = std::make_unique<std::array<int, N>>();
+    for (size_t i = 0; i < N; ++i) (*c)[i] = static_cast<int>(i);
+    return c;
+  }
+  static bool Lookup(const Container& c, int64_t i) { return (*c)[i] != 0; }
+  static int64_t Iterate(const Container& c, int64_t) {
+    int64_t sum = 0;
+    for (int x : *c) sum += x;
+    return sum;
+  }
+};
+
+// std::queue and std::priority_queue. You can only see the front, so there's
+// no lookup or iterate.
+template <typename Q>
+struct QueueOps {
+  using Container = Q;
+  static Container Fill(int64_t n) {
+    ScrambledOrder order(n);
+    Container c;
+    for (int64_t i = 0; i < n; ++i) {
+      c.push(MakeKey<typename Q::value_type>(order[i]));
+    }
+    return c;
+  }
+  static void EraseAll(Container& c, int64_t) {
+    while (!c.empty()) c.pop();
+  }
+};
+
+// Everything with insert/find/erase: the sets, maps and hash tables. Keys are
+// inserted in a scrambled order since sorted inserts are a best case for the
+// trees.
+template <typename C>
+struct AssociativeOps {
+  using Container = C;
+  using Key = typename C::key_type;
+
+  static typename C::value_type MakeValue(int64_t i) {
+    if constexpr (std::is_same_v<Key, typename C::value_type>) {
+      return MakeKey<Key>(i);
+    } else {
+      return {MakeKey<Key>(i), MakeKey<typename C::mapped_type>(i)};
+    }
+  }
+  static Container Fill(int64_t n) {
+    ScrambledOrder order(n);
+    Container c;
+    for (int64_t i = 0; i < n; ++i) c.insert(MakeValue(order[i]));
+    return c;
+  }
+  static bool Lookup(const Container& c, const Key& key) {
+    return c.find(key) != c.end();
+  }
+  static int64_t Iterate(const Container& c, int64_t) {
+    int64_t count = 0;
+    for (const auto& value : c) {
+      benchmark::DoNotOptimize(&value);
+      ++count;
+    }
+    return count;
+  }
+  static void EraseAll(Container& c, int64_t n) {
+    ScrambledOrder order(n);
+    for (int64_t i = 0; i < n; ++i) c.erase(MakeValue(order[i]));
+  }
+};
+
+// Maps erase by key, not by key/value pair.
+template <typename C>
+struct MapOps : AssociativeOps<C> {
+  using typename AssociativeOps<C>::Container;
+  static void EraseAll(Container& c, int64_t n) {
+    ScrambledOrder order(n);
+    for (int64_t i = 0; i < n; ++i) {
+      c.erase(MakeKey<typename C::key_type>(order[i]));
+    }
+  }
+};
+
+// std::unordered_set<Person> has to be handed its hash and equality functions,
+// like people_set in HashTables().
+using PersonHashSet =
+    std::unordered_set<Person, PersonNameHash, PersonNameEq>;
+
+// Picks up to kMaxLookupKeys keys spread across 0..n-1 in a scrambled order.
+template <typename Key>
+std::vector<Key> MakeLookupKeys(int64_t n) {
+  int64_t count = std::min(n, kMaxLookupKeys);
+  ScrambledOrder order(n);
+  std::vector<Key> keys;
+  keys.reserve(count);
+  for (int64_t i = 0; i < count; ++i) keys.push_back(MakeKey<Key>(order[i]));
+  return keys;
+}
+
+int64_t Size(const benchmark::State& state) { return state.range(0); }
+
+template <typename Ops>
+void BM_Insert(benchmark::State& state) {
+  const int64_t n = Size(state);
+  for (auto _ : state) {
+    auto c = Ops::Fill(n);
+    benchmark::DoNotOptimize(c);
+    // Freeing c is timed too. Pausing the timer around it is noisier than the
+    // free itself at small sizes.
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Arrays and vectors are looked up by index.
+template <typename Ops>
+void BM_IndexLookup(benchmark::State& state) {
+  const int64_t n = Size(state);
+  auto c = Ops::Fill(n);
+  const std::vector<uint32_t> indexes =
+      ScrambledIndexes(n, std::min(n, kMaxLookupKeys));
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Ops::Lookup(c, indexes[i]));
+    if (++i == indexes.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Ops>
+void BM_KeyLookup(benchmark::State& state) {
+  const int64_t n = Size(state);
+  auto c = Ops::Fill(n);
+  auto keys = MakeLookupKeys<typename Ops::Key>(n);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Ops::Lookup(c, keys[i]));
+    if (++i == keys.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Ops>
+void BM_Iterate(benchmark::State& state) {
+  const int64_t n = Size(state);
+  auto c = Ops::Fill(n);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Ops::Iterate(c, n));
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Ops>
+void BM_Erase(benchmark::State& state) {
+  const int64_t n = Size(state);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto c = Ops::Fill(n);
+    state.ResumeTiming();
+    Ops::EraseAll(c, n);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+void SizeSweep(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(10)->Range(10, 100'000'000)->Unit(benchmark::kMicrosecond);
+}
+
+// The std::array benchmarks ignore the size argument, but google benchmark
+// still wants one.
+template <size_t N>
+void FixedSize(benchmark::internal::Benchmark* b) {
+  b->Arg(N);
+}
+
+// Arrays()
+BENCHMARK_TEMPLATE(BM_Insert, RawArrayOps)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_IndexLookup, RawArrayOps)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, RawArrayOps)->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, UniquePtrArrayOps)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_IndexLookup, UniquePtrArrayOps)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, UniquePtrArrayOps)->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, VectorOps<int>)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_IndexLookup, VectorOps<int>)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, VectorOps<int>)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, VectorOps<int>)->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, QueueOps<std::queue<int>>)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, QueueOps<std::queue<int>>)->Apply(SizeSweep);
+
+// Trees()
+BENCHMARK_TEMPLATE(BM_Insert, AssociativeOps<std::set<int>>)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, AssociativeOps<std::set<int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, AssociativeOps<std::set<int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, AssociativeOps<std::set<int>>)->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, MapOps<std::map<std::string, int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, MapOps<std::map<std::string, int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, MapOps<std::map<std::string, int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, MapOps<std::map<std::string, int>>)
+    ->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, QueueOps<std::priority_queue<Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, QueueOps<std::priority_queue<Person>>)
+    ->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, AssociativeOps<absl::btree_set<Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, AssociativeOps<absl::btree_set<Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, AssociativeOps<absl::btree_set<Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, AssociativeOps<absl::btree_set<Person>>)
+    ->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, MapOps<absl::btree_map<std::string, Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, MapOps<absl::btree_map<std::string, Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, MapOps<absl::btree_map<std::string, Person>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, MapOps<absl::btree_map<std::string, Person>>)
+    ->Apply(SizeSweep);
+
+// HashTables()
+BENCHMARK_TEMPLATE(BM_Insert, MapOps<std::unordered_map<std::string, int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, MapOps<std::unordered_map<std::string, int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, MapOps<std::unordered_map<std::string, int>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, MapOps<std::unordered_map<std::string, int>>)
+    ->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, AssociativeOps<PersonHashSet>)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, AssociativeOps<PersonHashSet>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, AssociativeOps<PersonHashSet>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, AssociativeOps<PersonHashSet>)->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, AssociativeOps<std::set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup, AssociativeOps<std::set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, AssociativeOps<std::set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, AssociativeOps<std::set<std::string>>)
+    ->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, AssociativeOps<std::unordered_set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup,
+                   AssociativeOps<std::unordered_set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate, AssociativeOps<std::unordered_set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, AssociativeOps<std::unordered_set<std::string>>)
+    ->Apply(SizeSweep);
+
+BENCHMARK_TEMPLATE(BM_Insert, AssociativeOps<absl::flat_hash_set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_KeyLookup,
+                   AssociativeOps<absl::flat_hash_set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Iterate,
+                   AssociativeOps<absl::flat_hash_set<std::string>>)
+    ->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Erase, AssociativeOps<absl::flat_hash_set<std::string>>)
+    ->Apply(SizeSweep);
+
+// NotArrays(). std::pair and std::tuple hold a fixed handful of values, so
+// there's nothing to sweep over and they aren't benchmarked.
+BENCHMARK_TEMPLATE(BM_Insert, StdArrayOps<10>)->Apply(FixedSize<10>);
+BENCHMARK_TEMPLATE(BM_Insert, StdArrayOps<100'000>)->Apply(FixedSize<100'000>);
+BENCHMARK_TEMPLATE(BM_IndexLookup, StdArrayOps<10>)->Apply(FixedSize<10>);
+BENCHMARK_TEMPLATE(BM_IndexLookup, StdArrayOps<100'000>)
+    ->Apply(FixedSize<100'000>);
+BENCHMARK_TEMPLATE(BM_Iterate, StdArrayOps<10>)->Apply(FixedSize<10>);
+BENCHMARK_TEMPLATE(BM_Iterate, StdArrayOps<100'000>)
+    ->Apply(FixedSize<100'000>);
+
+}  // namespace
+
+BENCHMARK_MAIN();
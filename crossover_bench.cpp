@@ -0,0 +1,330 @@
+// Finds the size where hash tables actually start beating the trees.
+//
+// HashTables() claims the big-O difference between the tree-based sets/maps and
+// the hash tables doesn't matter until you're pushing 1 million+ elements. This
+// runs std::set, std::map, absl::btree_set, std::unordered_set and
+// absl::flat_hash_set side by side for int and std::string keys, under
+// sequential, uniform and Zipfian key distributions, and prints the measured
+// crossover N for each operation. N is always the number of different keys in
+// the container; the distribution only changes which keys they are and how
+// often each one is looked up or in what order they're erased. Run with:
+//   bazel run -c opt :crossover_bench -- --max_size=10000000
+//
+// This doesn't use the google benchmark runner since the whole point is to
+// compare results across sizes and containers, which it can't do.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Roughly 3 points per decade, with 50k and 5M included since that's the range
+// we care about.
+const int64_t kSizes[] = {1'000,     2'000,     5'000,     10'000,   20'000,
+                          50'000,    100'000,   200'000,   500'000,  1'000'000,
+                          2'000'000, 5'000'000, 10'000'000};
+
+// Each measurement does at least this many operations, building the container
+// more than once at small sizes, so the timer resolution doesn't matter.
+constexpr int64_t kMinOpsPerMeasurement = 1'000'000;
+
+enum class Distribution { kSequential, kUniform, kZipfian };
+const char* DistributionName(Distribution d) {
+  switch (d) {
+    case Distribution::kSequential:
+      return "sequential";
+    case Distribution::kUniform:
+      return "uniform";
+    case Distribution::kZipfian:
+      return "zipfian";
+  }
+  return "";
+}
+
+enum Op { kInsert, kLookup, kErase, kNumOps };
+const char* const kOpNames[] = {"insert", "lookup", "erase"};
+
+// Zipfian ranks in [0, n) using the method from Gray et al., "Quickly
+// Generating Billion-Record Synthetic Databases", same as YCSB. Rank 0 is the
+// hottest key.
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(int64_t n, double theta = 0.99) : n_(n), theta_(theta) {
+    double zeta2 = 0;
+    for (int64_t i = 1; i <= 2; ++i) zeta2 += 1.0 / std::pow(i, theta_);
+    for (int64_t i = 1; i <= n_; ++i) zetan_ += 1.0 / std::pow(i, theta_);
+    alpha_ = 1.0 / (1.0 - theta_);
+    eta_ = (1 - std::pow(2.0 / n_, 1 - theta_)) / (1 - zeta2 / zetan_);
+  }
+
+  int64_t operator()(std::mt19937_64& rng) {
+    double u = std::uniform_real_distribution<double>(0, 1)(rng);
+    double uz = u * zetan_;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return 1;
+    return static_cast<int64_t>(n_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+  }
+
+ private:
+  int64_t n_;
+  double theta_;
+  double zetan_ = 0;
+  double alpha_;
+  double eta_;
+};
+
+// The ids of the keys to insert, look up and then erase for one distribution
+// at one size. These get turned into ints or strings with MakeKey(). inserts
+// are always n different keys, and erases is the same keys in some order, so
+// the container really has n elements and every erase removes one.
+struct KeyIds {
+  std::vector<int64_t> inserts;
+  std::vector<int64_t> lookups;
+  std::vector<int64_t> erases;
+};
+
+// n different random ids.
+std::vector<int64_t> DistinctRandomIds(int64_t n, std::mt19937_64& rng) {
+  std::uniform_int_distribution<int64_t> any_key(0, 0x7fffffff);
+  absl::flat_hash_set<int64_t> seen;
+  seen.reserve(n);
+  std::vector<int64_t> ids;
+  ids.reserve(n);
+  while (static_cast<int64_t>(ids.size()) < n) {
+    int64_t id = any_key(rng);
+    if (seen.insert(id).second) ids.push_back(id);
+  }
+  return ids;
+}
+
+KeyIds MakeKeyIds(Distribution dist, int64_t n) {
+  std::mt19937_64 rng(n);
+  KeyIds ids;
+  ids.lookups.reserve(n);
+  switch (dist) {
+    case Distribution::kSequential:
+      ids.inserts.reserve(n);
+      for (int64_t i = 0; i < n; ++i) ids.inserts.push_back(i);
+      ids.lookups = ids.inserts;
+      ids.erases = ids.inserts;
+      break;
+    case Distribution::kUniform: {
+      ids.inserts = DistinctRandomIds(n, rng);
+      // Lookups hit keys that were inserted, picked uniformly.
+      std::uniform_int_distribution<int64_t> any_index(0, n - 1);
+      for (int64_t i = 0; i < n; ++i) {
+        ids.lookups.push_back(ids.inserts[any_index(rng)]);
+      }
+      ids.erases = ids.inserts;
+      break;
+    }
+    case Distribution::kZipfian: {
+      // The keys themselves are the same as for uniform. What's skewed is how
+      // often each one is used: inserts[0] is the hottest key, and since the
+      // ids are random the hot keys are spread all over the trees.
+      ids.inserts = DistinctRandomIds(n, rng);
+      ZipfianGenerator zipf(n);
+      for (int64_t i = 0; i < n; ++i) {
+        ids.lookups.push_back(ids.inserts[zipf(rng)]);
+      }
+      // Erases go in the order keys first come up in another Zipfian draw,
+      // so hot keys tend to go first, then whatever never came up.
+      std::vector<bool> erased(n, false);
+      ids.erases.reserve(n);
+      for (int64_t i = 0; i < n; ++i) {
+        int64_t rank = zipf(rng);
+        if (!erased[rank]) {
+          erased[rank] = true;
+          ids.erases.push_back(ids.inserts[rank]);
+        }
+      }
+      for (int64_t rank = 0; rank < n; ++rank) {
+        if (!erased[rank]) ids.erases.push_back(ids.inserts[rank]);
+      }
+      break;
+    }
+  }
+  return ids;
+}
+
+template <typename K>
+std::vector<K> ToKeys(const std::vector<int64_t>& ids) {
+  std::vector<K> keys;
+  keys.reserve(ids.size());
+  for (int64_t id : ids) keys.push_back(MakeKey<K>(id));
+  return keys;
+}
+
+template <typename C, typename K>
+void Insert(C& c, const K& key) {
+  if constexpr (std::is_same_v<typename C::value_type, K>) {
+    c.insert(key);
+  } else {
+    c.emplace(key, 0);
+  }
+}
+
+double NanosSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Nanoseconds per operation for insert, lookup and erase on one container.
+// Keys are inserted into an empty container, looked up, then all erased again.
+template <typename C, typename K>
+std::vector<double> Measure(const std::vector<K>& inserts,
+                            const std::vector<K>& lookups,
+                            const std::vector<K>& erases) {
+  const int64_t n = inserts.size();
+  const int64_t rounds = std::max<int64_t>(1, kMinOpsPerMeasurement / n);
+  std::vector<double> nanos(kNumOps, 0);
+  for (int64_t round = 0; round < rounds; ++round) {
+    C c;
+    auto start = std::chrono::steady_clock::now();
+    for (const K& key : inserts) Insert(c, key);
+    nanos[kInsert] += NanosSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (const K& key : lookups) {
+      benchmark::DoNotOptimize(c.find(key) != c.end());
+    }
+    nanos[kLookup] += NanosSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (const K& key : erases) c.erase(key);
+    nanos[kErase] += NanosSince(start);
+    benchmark::DoNotOptimize(c);
+  }
+  for (double& ns : nanos) ns /= rounds * n;
+  return nanos;
+}
+
+struct Contender {
+  const char* name;
+  bool is_tree;
+};
+const Contender kContenders[] = {
+    {"std::set", true},
+    {"std::map", true},
+    {"absl::btree_set", true},
+    {"std::unordered_set", false},
+    {"absl::flat_hash_set", false},
+};
+constexpr int kNumContenders = sizeof(kContenders) / sizeof(kContenders[0]);
+
+// results[size_index][contender][op] = ns/op.
+using Results = std::vector<std::vector<std::vector<double>>>;
+
+template <typename K>
+std::vector<std::vector<double>> MeasureAll(const KeyIds& ids) {
+  const std::vector<K> inserts = ToKeys<K>(ids.inserts);
+  const std::vector<K> lookups = ToKeys<K>(ids.lookups);
+  const std::vector<K> erases = ToKeys<K>(ids.erases);
+  // Same order as kContenders.
+  return {
+      Measure<std::set<K>>(inserts, lookups, erases),
+      Measure<std::map<K, int>>(inserts, lookups, erases),
+      Measure<absl::btree_set<K>>(inserts, lookups, erases),
+      Measure<std::unordered_set<K>>(inserts, lookups, erases),
+      Measure<absl::flat_hash_set<K>>(inserts, lookups, erases),
+  };
+}
+
+// The crossover is the smallest size where the hash table is faster than the
+// tree, and stays faster at every bigger size measured. Returns -1 if the tree
+// was still winning at the biggest size.
+int64_t Crossover(const Results& results, size_t num_sizes, int tree,
+                  int hash, Op op) {
+  int64_t crossover = -1;
+  for (size_t i = num_sizes; i-- > 0;) {
+    if (results[i][hash][op] >= results[i][tree][op]) break;
+    crossover = kSizes[i];
+  }
+  return crossover;
+}
+
+void PrintCrossovers(const char* key_name, Distribution dist,
+                     const Results& results, size_t num_sizes) {
+  for (int op = 0; op < kNumOps; ++op) {
+    printf("\n%s keys, %s distribution, %s (ns/op):\n", key_name,
+           DistributionName(dist), kOpNames[op]);
+    printf("%12s", "N");
+    for (const Contender& c : kContenders) printf("%21s", c.name);
+    printf("\n");
+    for (size_t i = 0; i < num_sizes; ++i) {
+      printf("%12" PRId64, kSizes[i]);
+      for (int c = 0; c < kNumContenders; ++c) {
+        printf("%21.1f", results[i][c][op]);
+      }
+      printf("\n");
+    }
+    for (int tree = 0; tree < kNumContenders; ++tree) {
+      if (!kContenders[tree].is_tree) continue;
+      for (int hash = 0; hash < kNumContenders; ++hash) {
+        if (kContenders[hash].is_tree) continue;
+        int64_t n =
+            Crossover(results, num_sizes, tree, hash, static_cast<Op>(op));
+        printf("  crossover %s vs %s: ", kContenders[tree].name,
+               kContenders[hash].name);
+        if (n < 0) {
+          printf("none up to %" PRId64 "\n", kSizes[num_sizes - 1]);
+        } else if (n == kSizes[0]) {
+          printf("<= %" PRId64 " (hash always faster)\n", n);
+        } else {
+          printf("%" PRId64 "\n", n);
+        }
+      }
+    }
+  }
+}
+
+template <typename K>
+void RunStudy(const char* key_name, int64_t max_size) {
+  size_t num_sizes = 0;
+  while (num_sizes < std::size(kSizes) && kSizes[num_sizes] <= max_size) {
+    ++num_sizes;
+  }
+  for (Distribution dist : {Distribution::kSequential, Distribution::kUniform,
+                            Distribution::kZipfian}) {
+    Results results;
+    for (size_t i = 0; i < num_sizes; ++i) {
+      fprintf(stderr, "%s %s N=%" PRId64 "\n", key_name,
+              DistributionName(dist), kSizes[i]);
+      results.push_back(MeasureAll<K>(MakeKeyIds(dist, kSizes[i])));
+    }
+    PrintCrossovers(key_name, dist, results, num_sizes);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t max_size = 10'000'000;
+  for (int i = 1; i < argc; ++i) {
+    if (sscanf(argv[i], "--max_size=%" SCNd64, &max_size) != 1) {
+      fprintf(stderr, "usage: %s [--max_size=N]\n", argv[0]);
+      return 1;
+    }
+  }
+  RunStudy<int>("int", max_size);
+  RunStudy<std::string>("std::string", max_size);
+  return 0;
+}
@@ -0,0 +1,115 @@
+// What InstrumentedVector reports for the vectors in Arrays(), and what it
+// costs. Run with:
+//   bazel run -c opt :growth_bench
+//
+// Each benchmark exports its vector's GrowthStats as counters, and the full
+// table gets printed at the end like a service would dump it.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "growth_stats.h"
+#include "instrumented_vector.h"
+#include "person.h"
+
+namespace {
+
+// Copies what a GrowthStats counted since `before` into the benchmark's
+// counters, per iteration. The benchmark library runs each benchmark a few
+// times to pick the iteration count, so the stats have more than one run in
+// them.
+void ExportCounters(benchmark::State& state, const GrowthStats& stats,
+                    const GrowthStatsSnapshot& before) {
+  GrowthStatsSnapshot s = Snapshot("", stats);
+  auto per_iter = [](double value) {
+    return benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+  };
+  state.counters["reallocs"] = per_iter(s.reallocations - before.reallocations);
+  state.counters["bytes_moved"] = per_iter(s.bytes_moved - before.bytes_moved);
+  state.counters["growth_us"] =
+      per_iter((s.growth_nanos - before.growth_nanos) / 1e3);
+  state.counters["peak_waste"] = s.peak_waste_bytes;
+}
+
+// nums_vector from Arrays(), filled one push_back at a time with and without
+// a reserve() first.
+void BM_NumsVector(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  const bool reserve = state.range(1);
+  GrowthStats& stats = GetGrowthStats(
+      "Arrays/nums_vector/" + std::to_string(n) + (reserve ? "/reserved" : ""));
+  GrowthStatsSnapshot before = Snapshot("", stats);
+  for (auto _ : state) {
+    InstrumentedVector<int> nums_vector(stats);
+    if (reserve) nums_vector.reserve(n);
+    for (int64_t i = 0; i < n; ++i) nums_vector.push_back(i);
+    benchmark::DoNotOptimize(nums_vector.data());
+  }
+  ExportCounters(state, stats, before);
+}
+BENCHMARK(BM_NumsVector)
+    ->ArgsProduct({{1'000, 1'000'000, 100'000'000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// A vector of Person, where every reallocation has to move the names too.
+void BM_People(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  GrowthStats& stats = GetGrowthStats("people/" + std::to_string(n));
+  GrowthStatsSnapshot before = Snapshot("", stats);
+  for (auto _ : state) {
+    InstrumentedVector<Person> people(stats);
+    for (int64_t i = 0; i < n; ++i) people.push_back(MakeKey<Person>(i));
+    benchmark::DoNotOptimize(people.data());
+  }
+  ExportCounters(state, stats, before);
+}
+BENCHMARK(BM_People)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+// The cost of the instrumentation itself on push_back, against a plain
+// std::vector.
+template <typename V>
+V MakeVector() {
+  if constexpr (std::is_same_v<V, std::vector<int>>) {
+    return V();
+  } else {
+    static GrowthStats& stats = GetGrowthStats("overhead");
+    return V(stats);
+  }
+}
+
+template <typename V>
+void BM_PushBackOverhead(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  for (auto _ : state) {
+    V nums_vector = MakeVector<V>();
+    for (int64_t i = 0; i < n; ++i) nums_vector.push_back(i);
+    benchmark::DoNotOptimize(nums_vector.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_PushBackOverhead, std::vector<int>)
+    ->RangeMultiplier(100)
+    ->Range(100, 1'000'000);
+BENCHMARK_TEMPLATE(BM_PushBackOverhead, InstrumentedVector<int>)
+    ->RangeMultiplier(100)
+    ->Range(100, 1'000'000);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  printf("\nGrowth stats for everything above:\n");
+  DumpGrowthStats(stdout);
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "growth_stats.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+struct Registry {
+  std::mutex mu;
+  // std::map never moves its values, and they're never erased, so references
+  // handed out stay valid.
+  std::map<std::string, GrowthStats, std::less<>> stats;
+};
+
+// Never destroyed, so vectors destroyed after main() returns can still
+// update their stats.
+Registry& GetRegistry() {
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+void UpdateMax(std::atomic<int64_t>& max, int64_t value) {
+  int64_t current = max.load(std::memory_order_relaxed);
+  while (value > current &&
+         !max.compare_exchange_weak(current, value,
+                                    std::memory_order_relaxed)) {
+  }
+}
+
+int HistogramBucket(int64_t nanos) {
+  int bucket = 0;
+  while (nanos > 1 && bucket < kGrowthHistogramBuckets - 1) {
+    nanos >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+void GrowthStats::RecordGrowth(int64_t moved_bytes, int64_t nanos) {
+  reallocations.fetch_add(1, std::memory_order_relaxed);
+  bytes_moved.fetch_add(moved_bytes, std::memory_order_relaxed);
+  growth_nanos.fetch_add(nanos, std::memory_order_relaxed);
+  UpdateMax(max_growth_nanos, nanos);
+  growth_histogram[HistogramBucket(nanos)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void GrowthStats::RecordFinalSize(int64_t size, int64_t waste_bytes) {
+  UpdateMax(peak_size, size);
+  UpdateMax(peak_waste_bytes, waste_bytes);
+}
+
+GrowthStats& GetGrowthStats(std::string_view name) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  auto it = registry.stats.find(name);
+  if (it == registry.stats.end()) {
+    it = registry.stats.try_emplace(std::string(name)).first;
+  }
+  return it->second;
+}
+
+GrowthStatsSnapshot Snapshot(std::string_view name, const GrowthStats& stats) {
+  auto get = [](const std::atomic<int64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  };
+  GrowthStatsSnapshot snapshot;
+  snapshot.name = std::string(name);
+  snapshot.instances = get(stats.instances);
+  snapshot.reallocations = get(stats.reallocations);
+  snapshot.bytes_moved = get(stats.bytes_moved);
+  snapshot.growth_nanos = get(stats.growth_nanos);
+  snapshot.max_growth_nanos = get(stats.max_growth_nanos);
+  for (const auto& bucket : stats.growth_histogram) {
+    snapshot.growth_histogram.push_back(get(bucket));
+  }
+  snapshot.peak_waste_bytes = get(stats.peak_waste_bytes);
+  snapshot.peak_size = get(stats.peak_size);
+  return snapshot;
+}
+
+std::vector<GrowthStatsSnapshot> SnapshotGrowthStats() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  std::vector<GrowthStatsSnapshot> snapshots;
+  for (const auto& [name, stats] : registry.stats) {
+    snapshots.push_back(Snapshot(name, stats));
+  }
+  return snapshots;
+}
+
+void DumpGrowthStats(FILE* out) {
+  std::vector<GrowthStatsSnapshot> snapshots = SnapshotGrowthStats();
+  std::stable_sort(snapshots.begin(), snapshots.end(),
+                   [](const GrowthStatsSnapshot& a,
+                      const GrowthStatsSnapshot& b) {
+                     return a.reallocations > b.reallocations;
+                   });
+  fprintf(out, "%-40s %10s %14s %14s %12s %12s %14s %12s\n", "name",
+          "instances", "reallocations", "bytes_moved", "growth_us",
+          "max_growth_us", "peak_waste", "peak_size");
+  for (const GrowthStatsSnapshot& s : snapshots) {
+    fprintf(out,
+            "%-40s %10" PRId64 " %14" PRId64 " %14" PRId64 " %12.1f %12.1f "
+            "%14" PRId64 " %12" PRId64 "\n",
+            s.name.c_str(), s.instances, s.reallocations, s.bytes_moved,
+            s.growth_nanos / 1e3, s.max_growth_nanos / 1e3,
+            s.peak_waste_bytes, s.peak_size);
+  }
+}
+
+void ResetGrowthStats() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  for (auto& [name, stats] : registry.stats) {
+    stats.instances = 0;
+    stats.reallocations = 0;
+    stats.bytes_moved = 0;
+    stats.growth_nanos = 0;
+    stats.max_growth_nanos = 0;
+    for (auto& bucket : stats.growth_histogram) bucket = 0;
+    stats.peak_waste_bytes = 0;
+    stats.peak_size = 0;
+  }
+}
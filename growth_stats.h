@@ -0,0 +1,82 @@
+#ifndef GROWTH_STATS_H_
+#define GROWTH_STATS_H_
+
+// Counters for how much work vectors spend growing, collected by
+// InstrumentedVector (instrumented_vector.h) under a name per call site.
+//
+// Every time a vector runs out of room it allocates a bigger array and moves
+// everything over. If that happens a lot for a vector whose final size you
+// could have guessed, it needs a reserve(). These counters tell you which
+// ones:
+//
+//   for (const GrowthStatsSnapshot& s : SnapshotGrowthStats()) ...
+//   DumpGrowthStats(stderr);
+//
+// All counters are updated with relaxed atomics, so vectors on any thread can
+// share a name.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Growth durations are bucketed by powers of two: bucket i counts growths
+// that took [2^i, 2^(i+1)) nanoseconds, and bucket 0 also gets the ones under
+// 1ns.
+constexpr int kGrowthHistogramBuckets = 40;
+
+struct GrowthStats {
+  // Vectors constructed under this name.
+  std::atomic<int64_t> instances{0};
+  // Times an insert (push_back, emplace_back, insert, resize) had to
+  // allocate a bigger array. reserve() and shrink_to_fit() reallocating
+  // don't count, since those were asked for.
+  std::atomic<int64_t> reallocations{0};
+  // Bytes of existing elements moved or copied by those reallocations.
+  std::atomic<int64_t> bytes_moved{0};
+  // Time spent in the inserts that reallocated, total and worst.
+  std::atomic<int64_t> growth_nanos{0};
+  std::atomic<int64_t> max_growth_nanos{0};
+  std::atomic<int64_t> growth_histogram[kGrowthHistogramBuckets] = {};
+  // The most capacity any one vector still had allocated but unused when it
+  // was destroyed, cleared or shrunk, in bytes.
+  std::atomic<int64_t> peak_waste_bytes{0};
+  // The most elements any one vector had at those points.
+  std::atomic<int64_t> peak_size{0};
+
+  void RecordGrowth(int64_t moved_bytes, int64_t nanos);
+  void RecordFinalSize(int64_t size, int64_t waste_bytes);
+};
+
+// The stats for `name`, created the first time it's asked for. The returned
+// reference is valid forever. This takes a lock, so look it up once (e.g. in
+// a function-local static) rather than every time you make a vector.
+GrowthStats& GetGrowthStats(std::string_view name);
+
+// A plain copy of one GrowthStats, for exporting.
+struct GrowthStatsSnapshot {
+  std::string name;
+  int64_t instances = 0;
+  int64_t reallocations = 0;
+  int64_t bytes_moved = 0;
+  int64_t growth_nanos = 0;
+  int64_t max_growth_nanos = 0;
+  std::vector<int64_t> growth_histogram;
+  int64_t peak_waste_bytes = 0;
+  int64_t peak_size = 0;
+};
+GrowthStatsSnapshot Snapshot(std::string_view name, const GrowthStats& stats);
+
+// Every name registered so far, sorted by name.
+std::vector<GrowthStatsSnapshot> SnapshotGrowthStats();
+
+// Prints one line per name. Names with the most reallocations first, since
+// those are the ones to look at for a missing reserve().
+void DumpGrowthStats(FILE* out);
+
+// Zeroes every counter, e.g. between benchmark runs.
+void ResetGrowthStats();
+
+#endif  // GROWTH_STATS_H_
@@ -0,0 +1,76 @@
+#include "huge_page.h"
+
+#include <atomic>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+std::atomic<int64_t> explicit_allocations{0};
+std::atomic<int64_t> transparent_allocations{0};
+std::atomic<int64_t> fallback_allocations{0};
+
+size_t RoundUpToHugePage(size_t bytes) {
+  return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+}
+
+}  // namespace
+
+HugePageStats GetHugePageStats() {
+  HugePageStats stats;
+  stats.explicit_allocations = explicit_allocations.load();
+  stats.transparent_allocations = transparent_allocations.load();
+  stats.fallback_allocations = fallback_allocations.load();
+  return stats;
+}
+
+#if defined(__linux__)
+
+void* AllocateHugePages(size_t bytes) {
+  const size_t size = RoundUpToHugePage(bytes);
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (ptr != MAP_FAILED) {
+    explicit_allocations.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+  }
+
+  // mmap only promises 4 KB alignment, and THP can only use a huge page for
+  // a 2 MB aligned 2 MB range. Map an extra huge page worth and trim both
+  // ends so the part that's left is aligned.
+  const size_t padded = size + kHugePageSize;
+  char* raw = static_cast<char*>(mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (raw == MAP_FAILED) throw std::bad_alloc();
+  char* aligned = reinterpret_cast<char*>(
+      RoundUpToHugePage(reinterpret_cast<uintptr_t>(raw)));
+  if (aligned != raw) munmap(raw, aligned - raw);
+  char* end = aligned + size;
+  if (raw + padded != end) munmap(end, raw + padded - end);
+
+  if (madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+    transparent_allocations.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    fallback_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  return aligned;
+}
+
+void FreeHugePages(void* ptr, size_t bytes) {
+  munmap(ptr, RoundUpToHugePage(bytes));
+}
+
+#else  // !defined(__linux__)
+
+void* AllocateHugePages(size_t bytes) {
+  fallback_allocations.fetch_add(1, std::memory_order_relaxed);
+  return ::operator new(bytes, std::align_val_t(kHugePageSize));
+}
+
+void FreeHugePages(void* ptr, size_t) {
+  ::operator delete(ptr, std::align_val_t(kHugePageSize));
+}
+
+#endif  // defined(__linux__)
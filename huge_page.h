@@ -0,0 +1,93 @@
+#ifndef HUGE_PAGE_H_
+#define HUGE_PAGE_H_
+
+// HugeVector<T> is a std::vector<T> whose big allocations are backed by 2 MB
+// "huge" pages instead of the normal 4 KB ones.
+//
+// Every memory access has to translate the virtual address to a physical one,
+// and the CPU caches those translations in the TLB, which only holds a couple
+// thousand entries. With 4 KB pages that covers a few MB, so randomly reading
+// a 10 GB array misses the TLB on nearly every access and has to walk the page
+// tables first. With 2 MB pages the same TLB covers GBs.
+//
+// Allocations of at least kHugePageSize go straight to mmap:
+//  1. First it asks for explicit huge pages (MAP_HUGETLB). Those only exist if
+//     an admin reserved some (vm.nr_hugepages), so this usually fails.
+//  2. Then it falls back to normal memory aligned to 2 MB with
+//     madvise(MADV_HUGEPAGE), which lets the kernel's transparent huge pages
+//     use 2 MB pages when it can. THP has to be set to "madvise" or "always"
+//     in /sys/kernel/mm/transparent_hugepage/enabled.
+//  3. If that's off too you just get normal pages, same as std::vector.
+// Smaller allocations use plain new/delete since they'd waste most of a 2 MB
+// page. On anything other than Linux it's all new/delete.
+//
+//   HugeVector<int> nums(10'000'000'000);
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+// Counts of how big allocations were actually backed, so you can tell whether
+// you're really getting huge pages.
+struct HugePageStats {
+  // Explicit huge pages from MAP_HUGETLB.
+  int64_t explicit_allocations = 0;
+  // Normal pages with MADV_HUGEPAGE. Whether the kernel actually used huge
+  // pages is up to it; check AnonHugePages in /proc/meminfo.
+  int64_t transparent_allocations = 0;
+  // Neither worked, so regular pages.
+  int64_t fallback_allocations = 0;
+};
+HugePageStats GetHugePageStats();
+
+// Allocates at least `bytes` bytes, which should be >= kHugePageSize, aligned
+// to kHugePageSize. Throws std::bad_alloc on failure.
+void* AllocateHugePages(size_t bytes);
+// Frees memory from AllocateHugePages. `bytes` has to be the same number
+// passed to AllocateHugePages.
+void FreeHugePages(void* ptr, size_t bytes);
+
+template <typename T>
+class HugePageAllocator {
+ public:
+  using value_type = T;
+
+  HugePageAllocator() noexcept = default;
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (UseHugePages(n)) {
+      return static_cast<T*>(AllocateHugePages(n * sizeof(T)));
+    }
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* ptr, size_t n) noexcept {
+    if (UseHugePages(n)) {
+      FreeHugePages(ptr, n * sizeof(T));
+    } else {
+      std::allocator<T>().deallocate(ptr, n);
+    }
+  }
+
+ private:
+  static bool UseHugePages(size_t n) { return n * sizeof(T) >= kHugePageSize; }
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+  return true;
+}
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+  return false;
+}
+
+template <typename T>
+using HugeVector = std::vector<T, HugePageAllocator<T>>;
+
+#endif  // HUGE_PAGE_H_
@@ -0,0 +1,80 @@
+// Random reads from big arrays with normal pages vs huge pages. Run with:
+//   bazel run -c opt :huge_page_bench
+//
+// Each iteration reads one element at a pseudo-random index. The indexes
+// come from a cheap LCG instead of a pre-made list so the list itself doesn't
+// compete for the cache and TLB. Once the array is much bigger than the TLB
+// can cover with 4 KB pages (a few MB), the huge page version should pull
+// ahead.
+//
+// The huge_pages counters show how the HugeVector was actually backed. If
+// they're all fallback, you're comparing std::vector with itself.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "huge_page.h"
+
+namespace {
+
+template <typename Vector>
+void BM_RandomRead(benchmark::State& state) {
+  const uint64_t n = state.range(0) / sizeof(int);
+  HugePageStats before = GetHugePageStats();
+  Vector nums(n, 1);
+  HugePageStats after = GetHugePageStats();
+
+  // n is a power of two, so masking keeps the index in range.
+  const uint64_t mask = n - 1;
+  uint64_t index = 1;
+  int64_t sum = 0;
+  for (auto _ : state) {
+    index = index * 6364136223846793005u + 1442695040888963407u;
+    sum += nums[(index >> 17) & mask];
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+  state.counters["explicit"] =
+      after.explicit_allocations - before.explicit_allocations;
+  state.counters["transparent"] =
+      after.transparent_allocations - before.transparent_allocations;
+  state.counters["fallback"] =
+      after.fallback_allocations - before.fallback_allocations;
+}
+
+// Pointer chasing: every read depends on the one before, so this measures
+// the full latency of a TLB miss instead of letting the CPU overlap them.
+template <typename Vector>
+void BM_DependentRead(benchmark::State& state) {
+  const uint64_t n = state.range(0) / sizeof(uint32_t);
+  Vector next(n);
+  // One big random cycle through every slot (Sattolo's algorithm).
+  for (uint64_t i = 0; i < n; ++i) next[i] = static_cast<uint32_t>(i);
+  uint64_t rng = 12345;
+  for (uint64_t i = n - 1; i > 0; --i) {
+    rng = rng * 6364136223846793005u + 1442695040888963407u;
+    uint64_t j = (rng >> 33) % i;
+    std::swap(next[i], next[j]);
+  }
+  uint32_t at = 0;
+  for (auto _ : state) at = next[at];
+  benchmark::DoNotOptimize(at);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void ArraySizes(benchmark::internal::Benchmark* b) {
+  // 1 MB to 2 GB.
+  b->RangeMultiplier(8)->Range(1 << 20, int64_t{1} << 31);
+}
+
+BENCHMARK_TEMPLATE(BM_RandomRead, std::vector<int>)->Apply(ArraySizes);
+BENCHMARK_TEMPLATE(BM_RandomRead, HugeVector<int>)->Apply(ArraySizes);
+BENCHMARK_TEMPLATE(BM_DependentRead, std::vector<uint32_t>)
+    ->Apply(ArraySizes);
+BENCHMARK_TEMPLATE(BM_DependentRead, HugeVector<uint32_t>)->Apply(ArraySizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();
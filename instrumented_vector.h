@@ -0,0 +1,273 @@
+#ifndef INSTRUMENTED_VECTOR_H_
+#define INSTRUMENTED_VECTOR_H_
+
+// InstrumentedVector<T> is a std::vector<T> that records how much time and
+// copying it spends growing, in the GrowthStats (growth_stats.h) for a name
+// you give it. Swap it in for a vector you're suspicious of, run the program,
+// and dump the stats:
+//
+//   InstrumentedVector<int> nums_vector("Arrays/nums_vector", array_size);
+//   nums_vector.push_back(777);
+//   ...
+//   DumpGrowthStats(stderr);
+//
+// Looking the name up takes a lock, so for vectors made in a hot loop, look
+// it up once and pass the GrowthStats in:
+//
+//   static GrowthStats& stats = GetGrowthStats("Request/scratch");
+//   InstrumentedVector<int> scratch(stats);
+//
+// If the stats show lots of reallocations and bytes moved for a vector whose
+// final size is predictable, it wants a reserve(). If peak_waste_bytes is
+// big, it reserved too much or grew and then shrank and wants a
+// shrink_to_fit().
+//
+// The overhead is one size vs capacity compare per insert, plus reading the
+// clock twice when an insert actually reallocates. That adds up for vectors
+// that only ever hold a handful of elements, so don't leave it on for those.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "growth_stats.h"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class InstrumentedVector {
+ public:
+  using Vector = std::vector<T, Allocator>;
+  using value_type = typename Vector::value_type;
+  using allocator_type = typename Vector::allocator_type;
+  using size_type = typename Vector::size_type;
+  using difference_type = typename Vector::difference_type;
+  using reference = typename Vector::reference;
+  using const_reference = typename Vector::const_reference;
+  using pointer = typename Vector::pointer;
+  using const_pointer = typename Vector::const_pointer;
+  using iterator = typename Vector::iterator;
+  using const_iterator = typename Vector::const_iterator;
+  using reverse_iterator = typename Vector::reverse_iterator;
+  using const_reverse_iterator = typename Vector::const_reverse_iterator;
+
+  explicit InstrumentedVector(GrowthStats& stats) : stats_(&stats) {
+    stats_->instances.fetch_add(1, std::memory_order_relaxed);
+  }
+  InstrumentedVector(GrowthStats& stats, size_type count)
+      : InstrumentedVector(stats) {
+    vec_.resize(count);
+  }
+  InstrumentedVector(GrowthStats& stats, std::initializer_list<T> init)
+      : InstrumentedVector(stats) {
+    vec_.assign(init);
+  }
+  explicit InstrumentedVector(std::string_view name)
+      : InstrumentedVector(GetGrowthStats(name)) {}
+  InstrumentedVector(std::string_view name, size_type count)
+      : InstrumentedVector(GetGrowthStats(name), count) {}
+  InstrumentedVector(std::string_view name, std::initializer_list<T> init)
+      : InstrumentedVector(GetGrowthStats(name), init) {}
+
+  // Copies count as another instance under the same name.
+  InstrumentedVector(const InstrumentedVector& other)
+      : vec_(other.vec_), stats_(other.stats_) {
+    stats_->instances.fetch_add(1, std::memory_order_relaxed);
+  }
+  InstrumentedVector(InstrumentedVector&& other) noexcept
+      : vec_(std::move(other.vec_)), stats_(other.stats_) {
+    stats_->instances.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Assignment only copies the elements. Each vector keeps its own name.
+  InstrumentedVector& operator=(const InstrumentedVector& other) {
+    RecordWaste();
+    vec_ = other.vec_;
+    return *this;
+  }
+  InstrumentedVector& operator=(InstrumentedVector&& other) noexcept {
+    RecordWaste();
+    vec_ = std::move(other.vec_);
+    return *this;
+  }
+  ~InstrumentedVector() { RecordWaste(); }
+
+  // The vector itself, for passing to code that takes a const std::vector&.
+  const Vector& vector() const { return vec_; }
+  GrowthStats& stats() const { return *stats_; }
+
+  reference operator[](size_type pos) { return vec_[pos]; }
+  const_reference operator[](size_type pos) const { return vec_[pos]; }
+  reference at(size_type pos) { return vec_.at(pos); }
+  const_reference at(size_type pos) const { return vec_.at(pos); }
+  reference front() { return vec_.front(); }
+  const_reference front() const { return vec_.front(); }
+  reference back() { return vec_.back(); }
+  const_reference back() const { return vec_.back(); }
+  T* data() noexcept { return vec_.data(); }
+  const T* data() const noexcept { return vec_.data(); }
+
+  iterator begin() noexcept { return vec_.begin(); }
+  const_iterator begin() const noexcept { return vec_.begin(); }
+  const_iterator cbegin() const noexcept { return vec_.cbegin(); }
+  iterator end() noexcept { return vec_.end(); }
+  const_iterator end() const noexcept { return vec_.end(); }
+  const_iterator cend() const noexcept { return vec_.cend(); }
+  reverse_iterator rbegin() noexcept { return vec_.rbegin(); }
+  const_reverse_iterator rbegin() const noexcept { return vec_.rbegin(); }
+  reverse_iterator rend() noexcept { return vec_.rend(); }
+  const_reverse_iterator rend() const noexcept { return vec_.rend(); }
+
+  bool empty() const noexcept { return vec_.empty(); }
+  size_type size() const noexcept { return vec_.size(); }
+  size_type capacity() const noexcept { return vec_.capacity(); }
+
+  void reserve(size_type new_capacity) { vec_.reserve(new_capacity); }
+  void shrink_to_fit() {
+    RecordWaste();
+    vec_.shrink_to_fit();
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    if (vec_.size() < vec_.capacity()) {
+      return vec_.emplace_back(std::forward<Args>(args)...);
+    }
+    GrowthTimer timer(this);
+    return vec_.emplace_back(std::forward<Args>(args)...);
+  }
+
+  void pop_back() { vec_.pop_back(); }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return emplace(pos, value);
+  }
+  iterator insert(const_iterator pos, T&& value) {
+    return emplace(pos, std::move(value));
+  }
+  iterator insert(const_iterator pos, size_type count, const T& value) {
+    if (vec_.size() + count <= vec_.capacity()) {
+      return vec_.insert(pos, count, value);
+    }
+    GrowthTimer timer(this);
+    return vec_.insert(pos, count, value);
+  }
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      // The count is known up front, so std::vector reallocates at most once.
+      if (vec_.size() + std::distance(first, last) <= vec_.capacity()) {
+        return vec_.insert(pos, first, last);
+      }
+      GrowthTimer timer(this);
+      return vec_.insert(pos, first, last);
+    } else {
+      // Pure input iterators can only be walked once. At the end that means
+      // growing one element at a time, so go through emplace_back to record
+      // every reallocation instead of lumping them into one. In the middle,
+      // collect them first and insert them in one go, which is what
+      // std::vector does too.
+      const difference_type offset = pos - vec_.cbegin();
+      if (pos == vec_.cend()) {
+        for (; first != last; ++first) emplace_back(*first);
+        return vec_.begin() + offset;
+      }
+      Vector items(first, last, vec_.get_allocator());
+      return insert(pos, std::make_move_iterator(items.begin()),
+                    std::make_move_iterator(items.end()));
+    }
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    if (vec_.size() < vec_.capacity()) {
+      return vec_.emplace(pos, std::forward<Args>(args)...);
+    }
+    GrowthTimer timer(this);
+    return vec_.emplace(pos, std::forward<Args>(args)...);
+  }
+
+  iterator erase(const_iterator pos) { return vec_.erase(pos); }
+  iterator erase(const_iterator first, const_iterator last) {
+    return vec_.erase(first, last);
+  }
+
+  void clear() noexcept {
+    RecordWaste();
+    vec_.clear();
+  }
+
+  void resize(size_type count) {
+    if (count <= vec_.capacity()) {
+      vec_.resize(count);
+      return;
+    }
+    GrowthTimer timer(this);
+    vec_.resize(count);
+  }
+  void resize(size_type count, const T& value) {
+    if (count <= vec_.capacity()) {
+      vec_.resize(count, value);
+      return;
+    }
+    GrowthTimer timer(this);
+    vec_.resize(count, value);
+  }
+
+  void swap(InstrumentedVector& other) noexcept { vec_.swap(other.vec_); }
+
+ private:
+  // Wraps an insert that might reallocate. If it did, records how many bytes
+  // had to move and how long the whole insert took.
+  class GrowthTimer {
+   public:
+    explicit GrowthTimer(InstrumentedVector* vector)
+        : vector_(vector),
+          old_size_(vector->vec_.size()),
+          old_capacity_(vector->vec_.capacity()),
+          start_(std::chrono::steady_clock::now()) {}
+    ~GrowthTimer() {
+      if (vector_->vec_.capacity() == old_capacity_) return;
+      int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start_)
+                          .count();
+      vector_->stats_->RecordGrowth(old_size_ * sizeof(T), nanos);
+    }
+
+   private:
+    InstrumentedVector* vector_;
+    size_t old_size_;
+    size_t old_capacity_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  // Called when the vector is done with its contents: destroyed, cleared,
+  // assigned over or shrunk. Right after a growth half the capacity is always
+  // unused, so that isn't interesting, but what's still unused at the end is.
+  void RecordWaste() {
+    stats_->RecordFinalSize(vec_.size(),
+                            (vec_.capacity() - vec_.size()) * sizeof(T));
+  }
+
+  Vector vec_;
+  GrowthStats* stats_;
+};
+
+template <typename T, typename Allocator>
+void swap(InstrumentedVector<T, Allocator>& a,
+          InstrumentedVector<T, Allocator>& b) noexcept {
+  a.swap(b);
+}
+
+#endif  // INSTRUMENTED_VECTOR_H_
@@ -11,6 +11,12 @@
 #include "absl/container/btree_map.h"
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_set.h"
+#include "chunked_deque.h"
+#include "person.h"
+#include "segmented_vector.h"
+#include "small_vector.h"
+#include "static_vector.h"
+#include "string_pool.h"
 
 void Arrays() {
   // Static arrays. The number in the [] _has_ to be a
@@ -23,6 +29,12 @@ void Arrays() {
   int my_nums[10];
   my_nums[0] = 5;
 
+  // If you really do want a fixed number of slots with no heap allocation,
+  // StaticVector (static_vector.h) is the safe version. It remembers how many
+  // elements you've added and checks you don't go past 10 in debug builds.
+  StaticVector<int, 10> my_static_nums;
+  my_static_nums.push_back(5);
+
   // Dynamic array with raw pointers. Array size can be known at runtime.
   // Generally using raw pointers and new/delete is kind of bad form since it's
   // easy to mess up or forget to delete. Or if an exception gets thrown you
@@ -57,16 +69,37 @@ void Arrays() {
   nums_vector.push_back(777);  // Adds an 11th element with value 777.
   nums_vector.pop_back();      // removes that element.
 
+  // The one real downside of vector is that every vector is at least one heap
+  // allocation, even if it only ever holds 3 ints. If you make millions of
+  // tiny vectors that adds up. SmallVector (small_vector.h) has the same
+  // methods as vector but keeps the first N elements inside the object itself,
+  // and only allocates once you go past N.
+  SmallVector<int, 8> small_nums = {1, 2, 3};
+  small_nums.push_back(4);  // Still no heap allocation.
+
+  // The other downside is that when a vector runs out of room, push_back
+  // moves every element to a new, bigger array. Any pointer you were holding
+  // to an element now points at freed memory. SegmentedVector
+  // (segmented_vector.h) grows by adding a new chunk instead, so elements
+  // never move.
+  SegmentedVector<int> stable_nums = {1, 2, 3};
+  int* first = &stable_nums[0];
+  stable_nums.push_back(4);
+  *first = 10;  // Still points at stable_nums[0].
+
   // std::queue and std::stack are both thin wrappers around std::vector. I
   // usually avoid std::stack because it's already very easy to push/pop with
   // vector's builtin functions. std::queue can be useful.
+  // The container underneath can be swapped out. ChunkedDeque
+  // (chunked_deque.h) stores elements in bigger blocks than the default
+  // std::deque does and reuses them, which is faster for a busy queue of big
+  // elements like Person.
+  std::queue<Person, ChunkedDeque<Person>> people_queue;
+  people_queue.push({"Brian", 39});
+  people_queue.pop();
 }
 
-struct Person {
-  std::string name;
-  int age;
-  bool operator<(const Person& rhs) const { return age < rhs.age; }
-};
+// Person lives in person.h so the benchmarks can use it too.
 
 void Trees() {
   // Set keeps one copy of every kind of value. The values are stored in a tree
@@ -198,6 +231,16 @@ void HashTables() {
   absl::flat_hash_set<std::string> more_names;
   // It has its own hashing system that has a handy way to combine the hashes
   // from multiple fields.
+
+  // When the same names show up over and over (in all the sets above and
+  // millions of times more), it's worth storing each one once and passing
+  // around a 4 byte id for it instead. Comparing and hashing ids is as cheap
+  // as it is for ints, and you can still get the string back.
+  StringPool name_pool;
+  StringId bill = name_pool.Intern("Bill");
+  printf("Same id: %d\n", name_pool.Intern("Bill") == bill);
+  printf("Interned name: %s\n", std::string(name_pool[bill]).c_str());
+  absl::flat_hash_set<StringId> name_ids = {bill, name_pool.Intern("Jen")};
 }
 
 void NotArrays() {
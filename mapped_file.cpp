@@ -0,0 +1,120 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path) : path_(path) {
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) ThrowErrno("open " + path);
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    int error = errno;
+    Close();
+    errno = error;
+    ThrowErrno("fstat " + path);
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* ptr =
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (ptr == MAP_FAILED) {
+      int error = errno;
+      size_ = 0;
+      Close();
+      errno = error;
+      ThrowErrno("mmap " + path);
+    }
+    data_ = static_cast<char*>(ptr);
+  }
+}
+
+MappedFile::~MappedFile() { Close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : path_(std::move(other.path_)),
+      fd_(std::exchange(other.fd_, -1)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Close();
+    path_ = std::move(other.path_);
+    fd_ = std::exchange(other.fd_, -1);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void MappedFile::Resize(size_t new_size) {
+  if (new_size == size_) return;
+  // Kept separately since the non-Linux path below clears size_ before it
+  // knows whether the new mapping worked.
+  const size_t old_size = size_;
+  if (ftruncate(fd_, new_size) != 0) ThrowErrno("ftruncate " + path_);
+  void* ptr;
+  if (new_size == 0) {
+    if (data_ != nullptr) munmap(data_, size_);
+    ptr = nullptr;
+  } else if (data_ == nullptr) {
+    ptr = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  } else {
+#if defined(__linux__)
+    // mremap can grow the mapping in place, or move it without copying
+    // anything since the pages are just remapped.
+    ptr = mremap(data_, size_, new_size, MREMAP_MAYMOVE);
+#else
+    // No mremap, so unmap and map it again. If the new mmap fails, the old
+    // size gets mapped again below.
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+    ptr = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+#endif
+  }
+  if (ptr == MAP_FAILED) {
+    // Put the file back to its old size so it still matches the mapping, and
+    // if the mapping is gone map it again so nothing is lost.
+    int error = errno;
+    if (ftruncate(fd_, old_size) == 0 && data_ == nullptr && old_size > 0) {
+      void* old_ptr = mmap(nullptr, old_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd_, 0);
+      if (old_ptr != MAP_FAILED) {
+        data_ = static_cast<char*>(old_ptr);
+        size_ = old_size;
+      }
+    }
+    errno = error;
+    ThrowErrno("mremap " + path_);
+  }
+  data_ = static_cast<char*>(ptr);
+  size_ = new_size;
+}
+
+void MappedFile::Sync() {
+  if (data_ != nullptr && msync(data_, size_, MS_SYNC) != 0) {
+    ThrowErrno("msync " + path_);
+  }
+}
+
+void MappedFile::Close() noexcept {
+  if (data_ != nullptr) munmap(data_, size_);
+  if (fd_ >= 0) close(fd_);
+  data_ = nullptr;
+  fd_ = -1;
+}
@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+// MappedFile maps a whole file into memory so you can read and write it like
+// an array. Writes go to the file (through the OS page cache) without any
+// explicit write calls. It's the building block for MmapVector.
+//
+// Only available on POSIX systems. Errors are thrown as std::system_error.
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+ public:
+  // Opens the file at `path`, creating it if it doesn't exist, and maps all of
+  // it read/write.
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  // Null while the file is empty.
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string& path() const { return path_; }
+
+  // Grows or shrinks the file and the mapping. Growing fills with zeros,
+  // without actually writing them to disk until you touch them. The mapping
+  // can move, so data() changes.
+  void Resize(size_t new_size);
+
+  // Blocks until everything written so far is on disk. Without this the OS
+  // still writes it out eventually, even if the process crashes, but not if
+  // the machine does.
+  void Sync();
+
+ private:
+  void Close() noexcept;
+
+  std::string path_;
+  int fd_ = -1;
+  char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // MAPPED_FILE_H_
@@ -0,0 +1,23 @@
+#include "memory_stats.h"
+
+#include <cstdio>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+int64_t CurrentRssBytes() {
+#if defined(__linux__)
+  // The second number in statm is resident pages.
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return 0;
+  long long total_pages = 0;
+  long long resident_pages = 0;
+  int matched = fscanf(statm, "%lld %lld", &total_pages, &resident_pages);
+  fclose(statm);
+  if (matched != 2) return 0;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
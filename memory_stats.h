@@ -0,0 +1,14 @@
+#ifndef MEMORY_STATS_H_
+#define MEMORY_STATS_H_
+
+// Process-level memory numbers for benchmarks. These come from the OS, so
+// unlike alloc_counter.h they include malloc's own overhead and memory malloc
+// is holding on to but hasn't given back yet.
+
+#include <cstdint>
+
+// Resident set size: how much physical memory the process is using right now.
+// Returns 0 where it isn't supported (only Linux is).
+int64_t CurrentRssBytes();
+
+#endif  // MEMORY_STATS_H_
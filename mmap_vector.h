@@ -0,0 +1,214 @@
+#ifndef MMAP_VECTOR_H_
+#define MMAP_VECTOR_H_
+
+// MmapVector<T> is a std::vector<T> that lives in a file instead of on the
+// heap. Everything you push_back is written to the file as you go (the OS
+// takes care of actually writing it out), and opening the same file later
+// gets all the elements back instantly: there's no deserializing, it just maps
+// the file into memory and only reads pages from disk when you touch them.
+// That also means it can hold more data than fits in RAM.
+//
+//   {
+//     MmapVector<int> nums("/data/nums.bin");
+//     for (int i = 0; i < 1000; ++i) nums.push_back(i);
+//   }
+//   MmapVector<int> reopened("/data/nums.bin");  // reopened.size() == 1000
+//
+// T has to be trivially copyable (ints, floats, plain structs without
+// pointers or std::strings) since the bytes are stored as is. For the same
+// reason a file written on one kind of machine might not read correctly on a
+// different one.
+//
+// Growing works like std::vector: the file's capacity doubles when it's full,
+// using ftruncate to grow the file and mremap to grow the mapping. Like
+// std::vector, that can move the data, so pointers and iterators are
+// invalidated by anything that grows it. The file keeps its extra capacity
+// when you close it; call shrink_to_fit() first if you care about the size on
+// disk. Only one MmapVector should have a given file open at a time.
+//
+// Errors opening or growing the file are thrown as std::system_error. Opening
+// a file that wasn't written by an MmapVector<T> with the same sizeof(T), or
+// one that has been cut short, throws std::runtime_error.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "mapped_file.h"
+
+template <typename T>
+class MmapVector {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "MmapVector stores raw bytes, so T has to be trivially "
+                "copyable.");
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // Opens the vector stored at `path`, or creates an empty one if the file
+  // doesn't exist or is empty.
+  explicit MmapVector(const std::string& path) : file_(path) {
+    if (file_.size() == 0) {
+      file_.Resize(sizeof(Header));
+      Header* header = GetHeader();
+      header->magic = kMagic;
+      header->element_size = sizeof(T);
+      header->size = 0;
+      return;
+    }
+    if (file_.size() < sizeof(Header) || GetHeader()->magic != kMagic) {
+      throw std::runtime_error(path + " is not an MmapVector file");
+    }
+    if (GetHeader()->element_size != sizeof(T)) {
+      throw std::runtime_error(path + " has the wrong element size");
+    }
+    if (GetHeader()->size > capacity()) {
+      throw std::runtime_error(path + " is truncated or corrupt: its header " +
+                               "says it holds more elements than fit");
+    }
+  }
+
+  MmapVector(MmapVector&&) noexcept = default;
+  MmapVector& operator=(MmapVector&&) noexcept = default;
+
+  // Element access.
+  reference at(size_type pos) {
+    if (pos >= size()) throw std::out_of_range("MmapVector::at");
+    return data()[pos];
+  }
+  const_reference at(size_type pos) const {
+    if (pos >= size()) throw std::out_of_range("MmapVector::at");
+    return data()[pos];
+  }
+  reference operator[](size_type pos) { return data()[pos]; }
+  const_reference operator[](size_type pos) const { return data()[pos]; }
+  reference front() { return data()[0]; }
+  const_reference front() const { return data()[0]; }
+  reference back() { return data()[size() - 1]; }
+  const_reference back() const { return data()[size() - 1]; }
+  T* data() { return reinterpret_cast<T*>(file_.data() + sizeof(Header)); }
+  const T* data() const {
+    return reinterpret_cast<const T*>(file_.data() + sizeof(Header));
+  }
+
+  iterator begin() { return data(); }
+  const_iterator begin() const { return data(); }
+  const_iterator cbegin() const { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator end() const { return data() + size(); }
+  const_iterator cend() const { return data() + size(); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  // Capacity.
+  bool empty() const { return size() == 0; }
+  size_type size() const { return GetHeader()->size; }
+  size_type capacity() const {
+    return (file_.size() - sizeof(Header)) / sizeof(T);
+  }
+  void reserve(size_type new_capacity) {
+    if (new_capacity > capacity()) {
+      file_.Resize(sizeof(Header) + new_capacity * sizeof(T));
+    }
+  }
+  void shrink_to_fit() { file_.Resize(sizeof(Header) + size() * sizeof(T)); }
+
+  // Modifiers.
+  void clear() { GetHeader()->size = 0; }
+
+  void push_back(const T& value) {
+    if (size() == capacity()) {
+      // value might be one of our elements, which could move when we grow.
+      T copy = value;
+      Grow(size() + 1);
+      data()[size()] = copy;
+    } else {
+      data()[size()] = value;
+    }
+    ++GetHeader()->size;
+  }
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    push_back(T(std::forward<Args>(args)...));
+    return back();
+  }
+  void pop_back() { --GetHeader()->size; }
+
+  iterator insert(const_iterator pos, const T& value) {
+    size_type offset = pos - begin();
+    push_back(value);
+    std::rotate(begin() + offset, end() - 1, end());
+    return begin() + offset;
+  }
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator out = begin() + (first - begin());
+    iterator new_end = std::copy(begin() + (last - begin()), end(), out);
+    GetHeader()->size = new_end - begin();
+    return out;
+  }
+
+  // New elements are value-initialized (zeroed for ints), like std::vector.
+  void resize(size_type count) { resize(count, T()); }
+  void resize(size_type count, const T& value) {
+    if (count > size()) {
+      T copy = value;
+      if (count > capacity()) Grow(count);
+      std::fill(end(), begin() + count, copy);
+    }
+    GetHeader()->size = count;
+  }
+
+  // Blocks until everything is on disk. See MappedFile::Sync().
+  void Sync() { file_.Sync(); }
+
+ private:
+  // Stored at the start of the file. 64 bytes so the elements after it start
+  // on a cache line.
+  struct alignas(64) Header {
+    uint64_t magic;
+    uint64_t element_size;
+    uint64_t size;
+  };
+  static_assert(alignof(T) <= alignof(Header),
+                "MmapVector can't align elements past 64 bytes.");
+  // "MMAPVEC1"
+  static constexpr uint64_t kMagic = 0x31434556504d4d4dull;
+
+  Header* GetHeader() { return reinterpret_cast<Header*>(file_.data()); }
+  const Header* GetHeader() const {
+    return reinterpret_cast<const Header*>(file_.data());
+  }
+
+  // Doubles like std::vector, but starts at a page worth of elements since
+  // every resize is a couple of system calls.
+  void Grow(size_type min_capacity) {
+    constexpr size_type kMinCapacity = std::max<size_type>(4096 / sizeof(T), 1);
+    reserve(std::max({min_capacity, capacity() * 2, kMinCapacity}));
+  }
+
+  MappedFile file_;
+};
+
+#endif  // MMAP_VECTOR_H_
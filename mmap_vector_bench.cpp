@@ -0,0 +1,125 @@
+// Building and reopening a big int array with MmapVector vs the usual
+// std::vector + write to a file + read it back. Run with:
+//   bazel run -c opt :mmap_vector_bench
+//
+// Files go in $TMPDIR (or /tmp). Put that on the same kind of disk the real
+// job uses or the numbers don't mean much. Note that the Load benchmarks read
+// a file that was just written, so it's all in the page cache; a cold start
+// after a reboot is slower for both, but MmapVector still only reads the pages
+// you touch.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "mmap_vector.h"
+
+namespace {
+
+std::string TempPath(const char* name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+}
+
+int64_t NumInts(const benchmark::State& state) {
+  return state.range(0) / sizeof(int);
+}
+
+// What the nightly job does today: build in memory, then write it out.
+void BM_BuildVectorAndWrite(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  const std::string path = TempPath("mmap_vector_bench_std.bin");
+  for (auto _ : state) {
+    std::vector<int> nums;
+    for (int64_t i = 0; i < n; ++i) nums.push_back(static_cast<int>(i));
+    FILE* file = fopen(path.c_str(), "wb");
+    fwrite(nums.data(), sizeof(int), nums.size(), file);
+    fclose(file);
+  }
+  std::remove(path.c_str());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_BuildMmapVector(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  const std::string path = TempPath("mmap_vector_bench_mmap.bin");
+  for (auto _ : state) {
+    std::remove(path.c_str());
+    MmapVector<int> nums(path);
+    for (int64_t i = 0; i < n; ++i) nums.push_back(static_cast<int>(i));
+  }
+  std::remove(path.c_str());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// Startup: get the data back into something you can index. `scan` = 1 also
+// reads every element, which is the fair comparison if you're going to touch
+// all of it anyway.
+void BM_LoadVector(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  const bool scan = state.range(1);
+  const std::string path = TempPath("mmap_vector_bench_std.bin");
+  {
+    std::vector<int> nums(n, 1);
+    FILE* file = fopen(path.c_str(), "wb");
+    fwrite(nums.data(), sizeof(int), nums.size(), file);
+    fclose(file);
+  }
+  for (auto _ : state) {
+    FILE* file = fopen(path.c_str(), "rb");
+    std::vector<int> nums(n);
+    benchmark::DoNotOptimize(fread(nums.data(), sizeof(int), n, file));
+    fclose(file);
+    int64_t sum = nums[n / 2];
+    if (scan) {
+      for (int x : nums) sum += x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  std::remove(path.c_str());
+}
+
+void BM_LoadMmapVector(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  const bool scan = state.range(1);
+  const std::string path = TempPath("mmap_vector_bench_mmap.bin");
+  {
+    std::remove(path.c_str());
+    MmapVector<int> nums(path);
+    nums.resize(n, 1);
+  }
+  for (auto _ : state) {
+    MmapVector<int> nums(path);
+    int64_t sum = nums[n / 2];
+    if (scan) {
+      for (int x : nums) sum += x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  std::remove(path.c_str());
+}
+
+void FileSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(16)
+      ->Range(1 << 20, 1 << 30)
+      ->Unit(benchmark::kMillisecond);
+}
+
+void LoadArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t bytes : {1 << 20, 1 << 24, 1 << 28, 1 << 30}) {
+    b->Args({bytes, 0})->Args({bytes, 1});
+  }
+  b->ArgNames({"bytes", "scan"})->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_BuildVectorAndWrite)->Apply(FileSizes);
+BENCHMARK(BM_BuildMmapVector)->Apply(FileSizes);
+BENCHMARK(BM_LoadVector)->Apply(LoadArgs);
+BENCHMARK(BM_LoadMmapVector)->Apply(LoadArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
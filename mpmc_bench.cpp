@@ -0,0 +1,106 @@
+// How MpmcQueue scales with the number of threads, against the std::queue +
+// std::mutex (+ std::condition_variable) it replaces. Run with:
+//   bazel run -c opt :mpmc_bench
+//
+// Every thread pushes an item and then pops one, so all threads are both
+// producers and consumers and the queue never runs dry for long. The
+// interesting number is items_per_second as threads go up: the mutex version
+// gets slower in total as more threads fight over the lock, the lock-free one
+// should hold up much better. Past the number of CPUs the machine has, both
+// mostly measure the scheduler.
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "mpmc_queue.h"
+
+namespace {
+
+// Has to be at least threads * kBulkSize or the bulk benchmark can deadlock.
+constexpr size_t kQueueCapacity = 1 << 12;
+constexpr size_t kBulkSize = 16;
+
+// The baseline, what the worker pools use today.
+template <typename T>
+class MutexQueue {
+ public:
+  explicit MutexQueue(size_t) {}
+  void Push(const T& value) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      queue_.push(value);
+    }
+    not_empty_.notify_one();
+  }
+  T Pop() {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_empty_.wait(lock, [this] { return !queue_.empty(); });
+    T value = queue_.front();
+    queue_.pop();
+    return value;
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable not_empty_;
+  std::queue<T> queue_;
+};
+
+// All the benchmark's threads share one queue. It's always empty again once
+// they're done, so it's fine to reuse it for the next run.
+template <typename Queue>
+Queue& SharedQueue() {
+  static Queue* queue = new Queue(kQueueCapacity);
+  return *queue;
+}
+
+template <typename Queue>
+void BM_PushPop(benchmark::State& state) {
+  Queue& queue = SharedQueue<Queue>();
+  int64_t sum = 0;
+  int64_t i = 0;
+  for (auto _ : state) {
+    queue.Push(i++);
+    sum += queue.Pop();
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same, kBulkSize items at a time with the bulk operations. Items are counted
+// one by one so the numbers line up with BM_PushPop.
+void BM_PushPopBulk(benchmark::State& state) {
+  using Queue = MpmcQueue<int64_t>;
+  Queue& queue = SharedQueue<Queue>();
+  int64_t items[kBulkSize] = {};
+  int64_t sum = 0;
+  for (auto _ : state) {
+    for (size_t pushed = 0; pushed < kBulkSize;) {
+      pushed += queue.TryPushBulk(items + pushed, kBulkSize - pushed);
+    }
+    for (size_t popped = 0; popped < kBulkSize;) {
+      size_t n = queue.TryPopBulk(items + popped, kBulkSize - popped);
+      if (n == 0) std::this_thread::yield();
+      popped += n;
+    }
+    sum += items[0];
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * kBulkSize);
+}
+
+BENCHMARK_TEMPLATE(BM_PushPop, MpmcQueue<int64_t>)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PushPop, MutexQueue<int64_t>)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK(BM_PushPopBulk)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
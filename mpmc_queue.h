@@ -0,0 +1,239 @@
+#ifndef MPMC_QUEUE_H_
+#define MPMC_QUEUE_H_
+
+// MpmcQueue<T> is a fixed-size queue any number of threads can push to and
+// pop from at the same time, without a mutex. It's the drop-in for the
+// std::queue + std::mutex a worker pool usually hands its tasks around with.
+//
+// This is Dmitry Vyukov's bounded MPMC queue:
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// Every slot in the ring buffer has a sequence number that says whose turn it
+// is. A producer that wants position `pos` waits for the slot's sequence to be
+// `pos` (meaning the consumer from the previous lap is done with it), claims
+// the position with a compare and swap on the shared tail, writes the item,
+// then sets the sequence to `pos + 1` to say it's ready. Consumers do the
+// mirror image. The only contended operation is that one compare and swap, and
+// producers and consumers contend on different counters.
+//
+//   MpmcQueue<Task> tasks(1024);
+//   // Any thread:
+//   tasks.Push(task);  // Waits while the queue is full.
+//   if (!tasks.TryPush(task)) ...  // Gives up instead.
+//   // Any thread:
+//   Task task = tasks.Pop();  // Waits while the queue is empty.
+//
+// The waiting versions spin for a bit and then yield, they never sleep on a
+// condition variable. That's right for a queue that's busy, but a consumer
+// waiting on an idle queue burns a CPU. If there's only ever one producer and
+// one consumer, SpscQueue is quite a bit faster.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+template <typename T>
+class MpmcQueue {
+ public:
+  // The capacity gets rounded up to a power of two so wrapping around is a
+  // mask instead of a division.
+  explicit MpmcQueue(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1),
+        slots_(static_cast<Slot*>(::operator new(
+            (mask_ + 1) * sizeof(Slot), std::align_val_t(alignof(Slot))))) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      ::new (static_cast<void*>(&slots_[i])) Slot;
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpmcQueue() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; head != tail; ++head) std::destroy_at(slots_[head & mask_].get());
+    std::destroy(slots_, slots_ + mask_ + 1);
+    ::operator delete(slots_, std::align_val_t(alignof(Slot)));
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // Returns false without doing anything if the queue is full.
+  bool TryPush(const T& value) { return TryEmplace(value); }
+  bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+  template <typename... Args>
+  bool TryEmplace(Args&&... args) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & mask_];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (diff == 0) {
+        // The slot is free. Try to claim it. On failure pos gets reloaded.
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // Still holds an item from the previous lap: the queue is full.
+        return false;
+      } else {
+        // Another producer got here first.
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void*>(slot->get())) T(std::forward<Args>(args)...);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false without doing anything if the queue is empty.
+  bool TryPop(T& out) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & mask_];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    out = std::move(*slot->get());
+    std::destroy_at(slot->get());
+    // Ready for the producer one lap from now.
+    slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Waiting versions of the above.
+  void Push(const T& value) {
+    for (int spins = 0; !TryPush(value);) Backoff(spins);
+  }
+  void Push(T&& value) {
+    // Only moved from when TryPush succeeds.
+    for (int spins = 0; !TryPush(std::move(value));) Backoff(spins);
+  }
+  T Pop() {
+    static_assert(std::is_default_constructible_v<T>,
+                  "Use TryPop with your own T to pop into.");
+    T out;
+    for (int spins = 0; !TryPop(out);) Backoff(spins);
+    return out;
+  }
+
+  // Pushes as many of items[0..count) as there's room for, in one go, and
+  // returns how many that was. The positions are claimed with a single compare
+  // and swap instead of one per item, which is where the win over a loop of
+  // TryPush comes from when there are lots of producers.
+  size_t TryPushBulk(const T* items, size_t count) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    size_t n;
+    do {
+      // Count how many slots in a row starting at pos are free for this lap.
+      n = 0;
+      while (n < count && n <= mask_ &&
+             slots_[(pos + n) & mask_].sequence.load(
+                 std::memory_order_acquire) == pos + n) {
+        ++n;
+      }
+      if (n == 0) {
+        size_t sequence =
+            slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+        if (static_cast<std::ptrdiff_t>(sequence - pos) < 0) return 0;
+        pos = tail_.load(std::memory_order_relaxed);
+        continue;
+      }
+    } while (n == 0 || !tail_.compare_exchange_weak(
+                           pos, pos + n, std::memory_order_relaxed));
+    for (size_t i = 0; i < n; ++i) {
+      Slot& slot = slots_[(pos + i) & mask_];
+      ::new (static_cast<void*>(slot.get())) T(items[i]);
+      slot.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return n;
+  }
+
+  // Pops up to max_count items into out[0..max_count) and returns how many.
+  size_t TryPopBulk(T* out, size_t max_count) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    size_t n;
+    do {
+      n = 0;
+      while (n < max_count && n <= mask_ &&
+             slots_[(pos + n) & mask_].sequence.load(
+                 std::memory_order_acquire) == pos + n + 1) {
+        ++n;
+      }
+      if (n == 0) {
+        size_t sequence =
+            slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+        if (static_cast<std::ptrdiff_t>(sequence - (pos + 1)) < 0) return 0;
+        pos = head_.load(std::memory_order_relaxed);
+        continue;
+      }
+    } while (n == 0 || !head_.compare_exchange_weak(
+                           pos, pos + n, std::memory_order_relaxed));
+    for (size_t i = 0; i < n; ++i) {
+      Slot& slot = slots_[(pos + i) & mask_];
+      out[i] = std::move(*slot.get());
+      std::destroy_at(slot.get());
+      slot.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    return n;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Only a snapshot, since other threads can change it right after.
+  size_t size_approx() const {
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t head = head_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+    T* get() { return reinterpret_cast<T*>(storage); }
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) power <<= 1;
+    return power;
+  }
+
+  static void Backoff(int& spins) {
+    if (++spins >= 64) {
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+
+  // See SpscQueue for why this is hardcoded.
+  static constexpr size_t kCacheLineSize = 64;
+
+  const size_t mask_;
+  Slot* const slots_;
+
+  // Where the next push goes, shared by all producers.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  // Where the next pop comes from, shared by all consumers.
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+};
+
+#endif  // MPMC_QUEUE_H_
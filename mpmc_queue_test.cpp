@@ -0,0 +1,143 @@
+#include "mpmc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(MpmcQueueTest, FullAndEmpty) {
+  MpmcQueue<int> queue(4);
+  EXPECT_EQ(queue.capacity(), 4);
+  int x;
+  EXPECT_FALSE(queue.TryPop(x));
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.TryPush(i));
+  EXPECT_FALSE(queue.TryPush(4));
+  EXPECT_EQ(queue.size_approx(), 4);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.TryPop(x));
+    EXPECT_EQ(x, i);
+  }
+  EXPECT_FALSE(queue.TryPop(x));
+  EXPECT_EQ(queue.size_approx(), 0);
+}
+
+// Every slot's sequence number goes around many laps.
+TEST(MpmcQueueTest, WrapsAround) {
+  MpmcQueue<int> queue(4);
+  int next_pop = 0;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(queue.TryPush(i));
+    if (i % 3 != 0) {
+      int x;
+      ASSERT_TRUE(queue.TryPop(x));
+      EXPECT_EQ(x, next_pop++);
+    }
+    if (queue.size_approx() == queue.capacity()) {
+      EXPECT_EQ(queue.Pop(), next_pop++);
+    }
+  }
+  for (int x; queue.TryPop(x);) EXPECT_EQ(x, next_pop++);
+  EXPECT_EQ(next_pop, 1000);
+}
+
+TEST(MpmcQueueTest, BulkWrapsAroundAndStopsWhenFull) {
+  MpmcQueue<int> queue(8);
+  const int items[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  EXPECT_EQ(queue.TryPushBulk(items, 5), 5);
+  int out[12];
+  ASSERT_EQ(queue.TryPopBulk(out, 3), 3);
+  EXPECT_EQ(out[2], 2);
+
+  // 2 left in the queue, so only 6 of these 7 fit, and they wrap past the
+  // end of the buffer.
+  EXPECT_EQ(queue.TryPushBulk(items + 5, 7), 6);
+  EXPECT_EQ(queue.TryPushBulk(items, 1), 0);
+
+  ASSERT_EQ(queue.TryPopBulk(out, 12), 8);
+  const int expected[] = {3, 4, 5, 6, 7, 8, 9, 10};
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(out[i], expected[i]);
+  EXPECT_EQ(queue.TryPopBulk(out, 12), 0);
+}
+
+TEST(MpmcQueueTest, DestroysLeftoverItems) {
+  auto item = std::make_shared<int>(1);
+  {
+    MpmcQueue<std::shared_ptr<int>> queue(4);
+    for (int i = 0; i < 3; ++i) {
+      queue.Push(item);
+      queue.Pop();
+    }
+    for (int i = 0; i < 3; ++i) queue.Push(item);
+    EXPECT_EQ(item.use_count(), 4);
+  }
+  EXPECT_EQ(item.use_count(), 1);
+}
+
+// Several producers and consumers, mixing single and bulk calls. Every item
+// has to come out exactly once, and any one consumer has to see each
+// producer's items in the order they were pushed.
+TEST(MpmcQueueTest, ManyThreadsDeliverEverythingOnce) {
+  constexpr int kProducers = 3;
+  constexpr int kConsumers = 3;
+  constexpr int64_t kItemsPerProducer = 50'000;
+  MpmcQueue<int64_t> queue(64);
+  std::vector<std::atomic<int>> seen(kProducers * kItemsPerProducer);
+  std::atomic<int64_t> popped{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p] {
+      const int64_t first = p * kItemsPerProducer;
+      int64_t next = 0;
+      int64_t batch[8];
+      while (next < kItemsPerProducer) {
+        size_t pushed;
+        if (p == 0) {
+          pushed = queue.TryPush(first + next) ? 1 : 0;
+        } else {
+          int64_t count = std::min<int64_t>(8, kItemsPerProducer - next);
+          for (int64_t i = 0; i < count; ++i) batch[i] = first + next + i;
+          pushed = queue.TryPushBulk(batch, count);
+        }
+        next += pushed;
+        if (pushed == 0) std::this_thread::yield();
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&, c] {
+      std::vector<int64_t> last(kProducers, -1);
+      int64_t out[8];
+      while (popped.load(std::memory_order_relaxed) <
+             kProducers * kItemsPerProducer) {
+        size_t n;
+        if (c == 0) {
+          n = queue.TryPop(out[0]) ? 1 : 0;
+        } else {
+          n = queue.TryPopBulk(out, 8);
+        }
+        for (size_t i = 0; i < n; ++i) {
+          seen[out[i]].fetch_add(1, std::memory_order_relaxed);
+          const int producer = out[i] / kItemsPerProducer;
+          EXPECT_GT(out[i], last[producer]);
+          last[producer] = out[i];
+        }
+        popped.fetch_add(n, std::memory_order_relaxed);
+        if (n == 0) std::this_thread::yield();
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (const std::atomic<int>& count : seen) ASSERT_EQ(count.load(), 1);
+  int64_t x;
+  EXPECT_FALSE(queue.TryPop(x));
+}
+
+}  // namespace
@@ -0,0 +1,242 @@
+#ifndef NODE_POOL_H_
+#define NODE_POOL_H_
+
+// NodePoolAllocator is an allocator for node-based containers like std::set,
+// std::map, std::list and std::unordered_map's nodes. Those containers make
+// one allocation per element, all exactly the same size. Instead of going to
+// malloc for each one, this hands out nodes from big chunks and keeps freed
+// nodes on a free list to reuse for the next insert.
+//
+//   std::set<int, std::less<int>, NodePoolAllocator<int>> int_set;
+//   std::map<std::string, int, std::less<std::string>,
+//            NodePoolAllocator<std::pair<const std::string, int>>> ages;
+//
+// Why bother: a long-running process that keeps inserting and erasing from
+// maps mixes those node allocations in with everything else it allocates.
+// Over time malloc's free memory gets chopped into holes that are the wrong
+// size for what's asked for next, so RSS slowly creeps up even though the
+// amount of live data stays flat. Pool nodes are only ever reused as nodes of
+// the same size, so the pool's memory stays at the peak number of live nodes.
+// The flip side is the pool never gives memory back to the OS.
+//
+// Each thread has its own free list so allocating and freeing nodes doesn't
+// take a lock. When a thread's list gets long (say it's freeing nodes another
+// thread allocated) it hands a batch of them to a shared list, which is also
+// where a thread looks before carving up a new chunk.
+//
+// Anything other than single-node allocations (like unordered_map's bucket
+// array) goes to plain new/delete.
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// All nodes of one size and alignment come from the same NodePool<Size,
+// Align>. It's all static, so e.g. std::set<int> and std::set<float> end up
+// sharing a pool if their nodes are the same size.
+template <size_t Size, size_t Align>
+class NodePool {
+ public:
+  static void* Allocate() {
+    if (cache_gone) return AllocateShared();
+    ThreadCache& cache = GetThreadCache();
+    if (cache.head == nullptr) cache.Refill();
+    FreeNode* node = cache.head;
+    cache.head = node->next;
+    --cache.count;
+    return node;
+  }
+
+  static void Deallocate(void* ptr) {
+    FreeNode* node = static_cast<FreeNode*>(ptr);
+    if (cache_gone) {
+      DeallocateShared(node);
+      return;
+    }
+    ThreadCache& cache = GetThreadCache();
+    node->next = cache.head;
+    cache.head = node;
+    if (++cache.count > 2 * kBatchSize) cache.ReleaseBatch();
+  }
+
+ private:
+  struct FreeNode {
+    FreeNode* next;
+  };
+  static_assert(Size >= sizeof(FreeNode) && Size % Align == 0,
+                "Use NodePoolAllocator, which rounds the size up.");
+
+  // How many nodes move between a thread and the shared list at a time.
+  static constexpr size_t kBatchSize = 256;
+  // New chunks hold this many nodes.
+  static constexpr size_t kNodesPerChunk = 1024;
+
+  // A singly linked list of free nodes. Usually exactly kBatchSize of them,
+  // but fewer for the leftovers from a thread that exited or nodes freed
+  // after that, and a whole chunk's worth when it's just been made.
+  struct Batch {
+    FreeNode* head;
+    size_t count;
+  };
+
+  // State shared by all threads. Never destroyed, since nodes can still be
+  // freed by other threads' exit handlers after main() returns.
+  struct Shared {
+    std::mutex mu;
+    std::vector<Batch> batches;
+    // Every chunk ever allocated. Never freed, but this keeps them reachable
+    // so leak checkers don't complain.
+    std::vector<void*> chunks;
+  };
+  static Shared& GetShared() {
+    static Shared* shared = new Shared;
+    return *shared;
+  }
+
+  // Makes a batch out of a new chunk. Called with shared.mu held.
+  static Batch NewChunk(Shared& shared) {
+    char* chunk = static_cast<char*>(
+        ::operator new(Size * kNodesPerChunk, std::align_val_t(Align)));
+    shared.chunks.push_back(chunk);
+    // Link the nodes front to back so they get handed out in address order.
+    FreeNode* head = nullptr;
+    for (size_t i = kNodesPerChunk; i-- > 0;) {
+      FreeNode* node = reinterpret_cast<FreeNode*>(chunk + i * Size);
+      node->next = head;
+      head = node;
+    }
+    return {head, kNodesPerChunk};
+  }
+
+  // For a thread whose cache has already been destroyed, e.g. a static
+  // std::set being destroyed after the main thread's thread_locals. These go
+  // straight to the shared list one node at a time.
+  static void* AllocateShared() {
+    Shared& shared = GetShared();
+    std::lock_guard<std::mutex> lock(shared.mu);
+    if (shared.batches.empty()) shared.batches.push_back(NewChunk(shared));
+    Batch& batch = shared.batches.back();
+    FreeNode* node = batch.head;
+    batch.head = node->next;
+    if (--batch.count == 0) shared.batches.pop_back();
+    return node;
+  }
+  static void DeallocateShared(FreeNode* node) {
+    Shared& shared = GetShared();
+    std::lock_guard<std::mutex> lock(shared.mu);
+    if (!shared.batches.empty() && shared.batches.back().count < kBatchSize) {
+      Batch& batch = shared.batches.back();
+      node->next = batch.head;
+      batch.head = node;
+      ++batch.count;
+    } else {
+      node->next = nullptr;
+      shared.batches.push_back({node, 1});
+    }
+  }
+
+  struct ThreadCache {
+    FreeNode* head = nullptr;
+    size_t count = 0;
+
+    ~ThreadCache() {
+      cache_gone = true;
+      if (head == nullptr) return;
+      Shared& shared = GetShared();
+      std::lock_guard<std::mutex> lock(shared.mu);
+      shared.batches.push_back({head, count});
+      head = nullptr;
+      count = 0;
+    }
+
+    // Grabs a batch from the shared list, or carves up a new chunk if there
+    // aren't any.
+    void Refill() {
+      Shared& shared = GetShared();
+      std::lock_guard<std::mutex> lock(shared.mu);
+      Batch batch;
+      if (shared.batches.empty()) {
+        batch = NewChunk(shared);
+      } else {
+        batch = shared.batches.back();
+        shared.batches.pop_back();
+      }
+      head = batch.head;
+      count = batch.count;
+    }
+
+    // Moves kBatchSize nodes from the front of this thread's list to the
+    // shared list.
+    void ReleaseBatch() {
+      Batch batch{head, kBatchSize};
+      FreeNode* last = head;
+      for (size_t i = 1; i < kBatchSize; ++i) last = last->next;
+      head = last->next;
+      last->next = nullptr;
+      count -= kBatchSize;
+      Shared& shared = GetShared();
+      std::lock_guard<std::mutex> lock(shared.mu);
+      shared.batches.push_back(batch);
+    }
+  };
+
+  static ThreadCache& GetThreadCache() {
+    thread_local ThreadCache cache;
+    return cache;
+  }
+
+  // Set once this thread's ThreadCache has been destroyed. Anything
+  // allocated or freed on the thread after that skips the cache, since its
+  // nodes now belong to the shared list. This has to live outside the cache:
+  // reading a member of an object that's been destroyed is undefined, but a
+  // bool has no destructor, so it stays readable until the thread is gone.
+  static inline thread_local bool cache_gone = false;
+};
+
+template <typename T>
+class NodePoolAllocator {
+ public:
+  using value_type = T;
+
+  NodePoolAllocator() noexcept = default;
+  template <typename U>
+  NodePoolAllocator(const NodePoolAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (n == 1) return static_cast<T*>(Pool::Allocate());
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* ptr, size_t n) noexcept {
+    if (n == 1) {
+      Pool::Deallocate(ptr);
+    } else {
+      std::allocator<T>().deallocate(ptr, n);
+    }
+  }
+
+ private:
+  // Nodes have to be big enough to hold the free list pointer while they're
+  // free, and the size has to be a multiple of the alignment so nodes packed
+  // next to each other in a chunk all stay aligned.
+  static constexpr size_t kAlign = std::max(alignof(T), alignof(void*));
+  static constexpr size_t kSize =
+      (std::max(sizeof(T), sizeof(void*)) + kAlign - 1) / kAlign * kAlign;
+  using Pool = NodePool<kSize, kAlign>;
+};
+
+// The pools are global, so any two NodePoolAllocators can free each other's
+// memory.
+template <typename T, typename U>
+bool operator==(const NodePoolAllocator<T>&, const NodePoolAllocator<U>&) {
+  return true;
+}
+template <typename T, typename U>
+bool operator!=(const NodePoolAllocator<T>&, const NodePoolAllocator<U>&) {
+  return false;
+}
+
+#endif  // NODE_POOL_H_
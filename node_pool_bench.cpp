@@ -0,0 +1,170 @@
+// NodePoolAllocator vs the default allocator for node-based containers under
+// insert/erase churn. Run with:
+//   bazel run -c opt :node_pool_bench
+//
+// BM_Churn is steady state: a set or map holding n elements where every step
+// erases a random element and inserts a new one.
+//
+// BM_Soak is a compressed version of a day in the life of one of our daemons.
+// Each "hour" the working set grows or shrinks to a new random size, while the
+// rest of the process makes and frees buffers of random sizes. It reports RSS
+// at the end next to the peak RSS and the RSS halfway through. The working set
+// in the second half is capped at the biggest it got in the first, so
+// rss_end_minus_half is pure creep. Run it with --benchmark_filter=Soak on its
+// own, since RSS is for the whole process. Each one takes a minute or two.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "memory_stats.h"
+#include "node_pool.h"
+#include "person.h"
+
+namespace {
+
+template <template <typename> class Alloc>
+using IntSet = std::set<int, std::less<int>, Alloc<int>>;
+template <template <typename> class Alloc>
+using AgesMap = std::map<std::string, int, std::less<std::string>,
+                         Alloc<std::pair<const std::string, int>>>;
+template <template <typename> class Alloc>
+using PeopleById =
+    std::map<int64_t, Person, std::less<int64_t>,
+             Alloc<std::pair<const int64_t, Person>>>;
+
+template <typename C>
+typename C::key_type KeyFor(int64_t i) {
+  using Key = typename C::key_type;
+  if constexpr (std::is_same_v<Key, int64_t>) {
+    return i;
+  } else {
+    return MakeKey<Key>(i);
+  }
+}
+
+template <typename C>
+void Insert(C& c, int64_t i) {
+  if constexpr (std::is_same_v<typename C::key_type, int>) {
+    c.insert(KeyFor<C>(i));
+  } else if constexpr (std::is_same_v<typename C::mapped_type, int>) {
+    c.emplace(KeyFor<C>(i), 40);
+  } else {
+    c.emplace(KeyFor<C>(i), MakeKey<Person>(i));
+  }
+}
+
+// Erases key i if it's there, otherwise inserts it. Keys come from a range
+// twice the size of the container, so it hovers around n elements.
+template <typename C>
+void Toggle(C& c, int64_t i) {
+  if (c.erase(KeyFor<C>(i)) == 0) Insert(c, i);
+}
+
+template <typename C>
+void BM_Churn(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  std::mt19937_64 rng(state.thread_index());
+  std::uniform_int_distribution<int64_t> any_key(0, 2 * n - 1);
+  C c;
+  for (int64_t i = 0; i < n; ++i) Insert(c, any_key(rng));
+  for (auto _ : state) Toggle(c, any_key(rng));
+  state.SetItemsProcessed(state.iterations());
+}
+
+void ChurnSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+}
+
+BENCHMARK_TEMPLATE(BM_Churn, IntSet<std::allocator>)->Apply(ChurnSizes);
+BENCHMARK_TEMPLATE(BM_Churn, IntSet<NodePoolAllocator>)->Apply(ChurnSizes);
+BENCHMARK_TEMPLATE(BM_Churn, AgesMap<std::allocator>)->Apply(ChurnSizes);
+BENCHMARK_TEMPLATE(BM_Churn, AgesMap<NodePoolAllocator>)->Apply(ChurnSizes);
+BENCHMARK_TEMPLATE(BM_Churn, PeopleById<std::allocator>)->Apply(ChurnSizes);
+BENCHMARK_TEMPLATE(BM_Churn, PeopleById<NodePoolAllocator>)
+    ->Apply(ChurnSizes);
+// Every thread churns its own set, which exercises the thread-local free lists.
+BENCHMARK_TEMPLATE(BM_Churn, IntSet<std::allocator>)
+    ->Arg(1 << 16)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Churn, IntSet<NodePoolAllocator>)
+    ->Arg(1 << 16)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+template <template <typename> class Alloc>
+void BM_Soak(benchmark::State& state) {
+  const int hours = state.range(0);
+  const int64_t ops_per_hour = state.range(1);
+  constexpr int64_t kMaxWorkingSet = 1 << 20;
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<int64_t> any_key(0, 2 * kMaxWorkingSet - 1);
+  std::uniform_int_distribution<int64_t> working_set_size(kMaxWorkingSet / 8,
+                                                          kMaxWorkingSet);
+  // Everything else the process is allocating in the meantime.
+  std::uniform_int_distribution<size_t> buffer_size(16, 4096);
+
+  const int64_t rss_start = CurrentRssBytes();
+  int64_t rss_peak = 0;
+  int64_t rss_half = 0;
+  for (auto _ : state) {
+    PeopleById<Alloc> people;
+    IntSet<Alloc> ids;
+    std::vector<std::unique_ptr<char[]>> buffers(1024);
+    int64_t first_half_peak = 0;
+    for (int hour = 0; hour < hours; ++hour) {
+      int64_t target = working_set_size(rng);
+      if (hour > hours / 2) target = std::min(target, first_half_peak);
+      for (int64_t op = 0; op < ops_per_hour; ++op) {
+        int64_t key = any_key(rng);
+        if (static_cast<int64_t>(people.size()) < target) {
+          Insert(people, key);
+          Insert(ids, key);
+        } else {
+          auto it = people.lower_bound(key);
+          if (it == people.end()) it = people.begin();
+          ids.erase(static_cast<int>(it->first));
+          people.erase(it);
+        }
+        buffers[key % buffers.size()].reset(new char[buffer_size(rng)]);
+      }
+      rss_peak = std::max(rss_peak, CurrentRssBytes() - rss_start);
+      if (hour <= hours / 2) {
+        // people only grows while it's below the target, so its size at the
+        // end of each hour is the most it held during that hour.
+        first_half_peak = std::max<int64_t>(first_half_peak, people.size());
+      }
+      if (hour == hours / 2) rss_half = CurrentRssBytes() - rss_start;
+    }
+    state.counters["rss_end"] = CurrentRssBytes() - rss_start;
+  }
+  state.counters["rss_peak"] = rss_peak;
+  state.counters["rss_half"] = rss_half;
+  state.counters["rss_end_minus_half"] =
+      state.counters["rss_end"].value - rss_half;
+}
+
+BENCHMARK_TEMPLATE(BM_Soak, std::allocator)
+    ->Args({24, 2'000'000})
+    ->ArgNames({"hours", "ops_per_hour"})
+    ->Iterations(1)
+    ->Unit(benchmark::kSecond);
+BENCHMARK_TEMPLATE(BM_Soak, NodePoolAllocator)
+    ->Args({24, 2'000'000})
+    ->ArgNames({"hours", "ops_per_hour"})
+    ->Iterations(1)
+    ->Unit(benchmark::kSecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,280 @@
+#include "packed_int_array.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include "simd_kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PACKED_INT_ARRAY_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+// Enough for the widest load the decoders do past the last value's first
+// byte: an AVX2 gather reads up to 32 bytes ahead.
+constexpr size_t kPadding = 32;
+
+int BitWidth(uint32_t x) { return x == 0 ? 0 : 32 - __builtin_clz(x); }
+
+uint32_t LowBits(int width) {
+  return width == 32 ? ~uint32_t{0} : (uint32_t{1} << width) - 1;
+}
+
+// Appends count values of `width` bits each to out, lowest bit first, padded
+// to a whole byte at the end.
+void PackBits(const int* values, size_t count, uint32_t base, int width,
+              std::vector<uint8_t>& out) {
+  uint64_t buffer = 0;
+  int buffered = 0;
+  for (size_t i = 0; i < count; ++i) {
+    // Subtracting as unsigned wraps around instead of overflowing, and the
+    // result is the right distance even if the two are far apart.
+    buffer |= uint64_t{static_cast<uint32_t>(values[i]) - base} << buffered;
+    buffered += width;
+    while (buffered >= 8) {
+      out.push_back(static_cast<uint8_t>(buffer));
+      buffer >>= 8;
+      buffered -= 8;
+    }
+  }
+  if (buffered > 0) out.push_back(static_cast<uint8_t>(buffer));
+}
+
+uint32_t ReadBits(const uint8_t* data, size_t bit, int width) {
+  uint64_t word;
+  std::memcpy(&word, data + bit / 8, sizeof(word));
+  return static_cast<uint32_t>(word >> (bit % 8)) & LowBits(width);
+}
+
+// out[i] = base + value number first + i, for count values packed `width`
+// bits each starting at data.
+void UnpackScalar(const uint8_t* data, size_t first, size_t count, int width,
+                  uint32_t base, int* out) {
+  for (size_t i = 0; i < count; ++i) {
+    const uint32_t value = ReadBits(data, (first + i) * width, width);
+    out[i] = static_cast<int>(base + value);
+  }
+}
+
+#ifdef PACKED_INT_ARRAY_X86
+// Eight values at a time. Each lane gathers the 4 bytes starting at the byte
+// its value starts in, then shifts and masks. A value can start up to 7 bits
+// into its first byte, so this only works for widths up to 25. Wider ones are
+// rare enough for ints that they just use the scalar loop.
+TARGET_AVX2 void UnpackAvx2(const uint8_t* data, size_t first, size_t count,
+                            int width, uint32_t base, int* out) {
+  size_t i = 0;
+  if (width <= 25) {
+    const __m256i lane_bits = _mm256_mullo_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(width));
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(LowBits(width)));
+    const __m256i seven = _mm256_set1_epi32(7);
+    const __m256i bases = _mm256_set1_epi32(static_cast<int>(base));
+    for (; i + 8 <= count; i += 8) {
+      const size_t bit = (first + i) * width;
+      const __m256i bits = _mm256_add_epi32(
+          lane_bits, _mm256_set1_epi32(static_cast<int>(bit % 8)));
+      const __m256i words = _mm256_i32gather_epi32(
+          reinterpret_cast<const int*>(data + bit / 8),
+          _mm256_srli_epi32(bits, 3), 1);
+      const __m256i values = _mm256_and_si256(
+          _mm256_srlv_epi32(words, _mm256_and_si256(bits, seven)), mask);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                          _mm256_add_epi32(values, bases));
+    }
+  }
+  UnpackScalar(data, first + i, count - i, width, base, out + i);
+}
+#endif
+
+void Unpack(const uint8_t* data, size_t first, size_t count, int width,
+            uint32_t base, int* out) {
+#ifdef PACKED_INT_ARRAY_X86
+  if (simd::ActiveSimdLevel() >= simd::SimdLevel::kAvx2) {
+    UnpackAvx2(data, first, count, width, base, out);
+    return;
+  }
+#endif
+  UnpackScalar(data, first, count, width, base, out);
+}
+
+// Zigzag maps small negative and positive deltas both to small unsigned
+// numbers (0, -1, 1, -2, ... become 0, 1, 2, 3, ...), so they get short
+// varints.
+uint32_t ZigZag(uint32_t delta) { return (delta << 1) ^ (0 - (delta >> 31)); }
+uint32_t UnZigZag(uint32_t zigzag) {
+  return (zigzag >> 1) ^ (0 - (zigzag & 1));
+}
+
+// 7 bits per byte, lowest first, with the top bit set on every byte but the
+// last.
+void PutVarint(uint32_t value, std::vector<uint8_t>& out) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t GetVarint(const uint8_t*& data) {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t byte = *data++;
+    value |= uint32_t{byte & 0x7fu} << shift;
+    if (byte < 0x80) return value;
+  }
+}
+
+}  // namespace
+
+const char* PackedIntArray::EncodingName(Encoding encoding) {
+  switch (encoding) {
+    case Encoding::kFixedWidth:
+      return "fixed_width";
+    case Encoding::kFrameOfReference:
+      return "frame_of_reference";
+    case Encoding::kDeltaVarint:
+      return "delta_varint";
+  }
+  return "";
+}
+
+PackedIntArray PackedIntArray::Build(absl::Span<const int> values,
+                                     Encoding encoding) {
+  PackedIntArray packed;
+  packed.encoding_ = encoding;
+  packed.size_ = values.size();
+  const size_t num_blocks = (values.size() + kBlockSize - 1) / kBlockSize;
+  switch (encoding) {
+    case Encoding::kFixedWidth: {
+      if (values.empty()) break;
+      const auto [min, max] = std::minmax_element(values.begin(), values.end());
+      packed.base_ = static_cast<uint32_t>(*min);
+      packed.width_ = BitWidth(static_cast<uint32_t>(*max) - packed.base_);
+      packed.data_.reserve(values.size() * packed.width_ / 8 + 1 + kPadding);
+      PackBits(values.data(), values.size(), packed.base_, packed.width_,
+               packed.data_);
+      break;
+    }
+    case Encoding::kFrameOfReference:
+      packed.block_base_.reserve(num_blocks);
+      packed.block_offset_.reserve(num_blocks);
+      packed.block_width_.reserve(num_blocks);
+      for (size_t start = 0; start < values.size(); start += kBlockSize) {
+        const absl::Span<const int> block = values.subspan(start, kBlockSize);
+        const auto [min, max] = std::minmax_element(block.begin(), block.end());
+        const uint32_t base = static_cast<uint32_t>(*min);
+        const int width = BitWidth(static_cast<uint32_t>(*max) - base);
+        packed.block_base_.push_back(base);
+        packed.block_offset_.push_back(packed.data_.size());
+        packed.block_width_.push_back(static_cast<uint8_t>(width));
+        PackBits(block.data(), block.size(), base, width, packed.data_);
+      }
+      break;
+    case Encoding::kDeltaVarint:
+      packed.block_base_.reserve(num_blocks);
+      packed.block_offset_.reserve(num_blocks);
+      for (size_t start = 0; start < values.size(); start += kBlockSize) {
+        const absl::Span<const int> block = values.subspan(start, kBlockSize);
+        packed.block_base_.push_back(static_cast<uint32_t>(block[0]));
+        packed.block_offset_.push_back(packed.data_.size());
+        for (size_t i = 1; i < block.size(); ++i) {
+          PutVarint(ZigZag(static_cast<uint32_t>(block[i]) -
+                           static_cast<uint32_t>(block[i - 1])),
+                    packed.data_);
+        }
+      }
+      break;
+  }
+  packed.data_.resize(packed.data_.size() + kPadding);
+  packed.data_.shrink_to_fit();
+  return packed;
+}
+
+PackedIntArray PackedIntArray::BuildSmallest(absl::Span<const int> values) {
+  PackedIntArray best = Build(values, Encoding::kFixedWidth);
+  for (Encoding encoding :
+       {Encoding::kFrameOfReference, Encoding::kDeltaVarint}) {
+    PackedIntArray packed = Build(values, encoding);
+    if (packed.bytes_used() < best.bytes_used()) best = std::move(packed);
+  }
+  return best;
+}
+
+int PackedIntArray::operator[](size_t pos) const {
+  assert(pos < size_ && "PackedIntArray index out of range");
+  const size_t block = pos / kBlockSize;
+  switch (encoding_) {
+    case Encoding::kFixedWidth:
+      return static_cast<int>(base_ +
+                              ReadBits(data_.data(), pos * width_, width_));
+    case Encoding::kFrameOfReference: {
+      const int width = block_width_[block];
+      return static_cast<int>(
+          block_base_[block] +
+          ReadBits(data_.data() + block_offset_[block],
+                   (pos % kBlockSize) * width, width));
+    }
+    case Encoding::kDeltaVarint: {
+      const uint8_t* data = data_.data() + block_offset_[block];
+      uint32_t value = block_base_[block];
+      for (size_t i = pos % kBlockSize; i > 0; --i) {
+        value += UnZigZag(GetVarint(data));
+      }
+      return static_cast<int>(value);
+    }
+  }
+  return 0;
+}
+
+void PackedIntArray::Decode(size_t begin, absl::Span<int> out) const {
+  assert(begin + out.size() <= size_ && "PackedIntArray index out of range");
+  if (encoding_ == Encoding::kFixedWidth) {
+    Unpack(data_.data(), begin, out.size(), width_, base_, out.data());
+    return;
+  }
+  // The others go a block at a time. Only the first and last blocks can be
+  // partial.
+  int partial[kBlockSize];
+  size_t done = 0;
+  while (done < out.size()) {
+    const size_t pos = begin + done;
+    const size_t block = pos / kBlockSize;
+    const size_t in_block = pos % kBlockSize;
+    const size_t count = std::min(kBlockSize - in_block, out.size() - done);
+    if (encoding_ == Encoding::kFrameOfReference) {
+      Unpack(data_.data() + block_offset_[block], in_block, count,
+             block_width_[block], block_base_[block], out.data() + done);
+    } else if (in_block == 0) {
+      DecodeDeltaBlock(block, count, out.data() + done);
+    } else {
+      DecodeDeltaBlock(block, in_block + count, partial);
+      std::copy_n(partial + in_block, count, out.data() + done);
+    }
+    done += count;
+  }
+}
+
+// Decodes the first `count` values of a kDeltaVarint block into out. The
+// varints are decoded into out as deltas after the block's first value, and
+// then a running sum turns them back into the values.
+void PackedIntArray::DecodeDeltaBlock(size_t block, size_t count,
+                                      int* out) const {
+  const uint8_t* data = data_.data() + block_offset_[block];
+  out[0] = static_cast<int>(block_base_[block]);
+  for (size_t i = 1; i < count; ++i) {
+    out[i] = static_cast<int>(UnZigZag(GetVarint(data)));
+  }
+  simd::PrefixSum(absl::MakeConstSpan(out, count), absl::MakeSpan(out, count));
+}
+
+std::vector<int> PackedIntArray::ToVector() const {
+  std::vector<int> values(size_);
+  Decode(0, absl::MakeSpan(values));
+  return values;
+}
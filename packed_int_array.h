@@ -0,0 +1,102 @@
+#ifndef PACKED_INT_ARRAY_H_
+#define PACKED_INT_ARRAY_H_
+
+// PackedIntArray is a read-only, compressed copy of a std::vector<int>.
+//
+// Most int columns don't need 32 bits per value. Every Person's age fits in
+// 7, and ids handed out in order are mostly small steps from the one before.
+// This stores them in about as many bits as they really need, with three
+// ways of doing it:
+//
+//   kFixedWidth        Subtracts the smallest value from everything and
+//                      stores each result in the same number of bits, just
+//                      enough for the biggest one. Ages 0..127 take 7 bits.
+//   kFrameOfReference  The same, but separately for every 128 values, each
+//                      block with its own smallest value and bit count. Much
+//                      better when nearby values are close together but the
+//                      whole range is big, like sorted ids.
+//   kDeltaVarint       Stores the difference from the previous value, in 1
+//                      byte if it's under 64 in size, 2 if under 8192, and so
+//                      on. Best for sorted data with small, uneven gaps.
+//
+//   std::vector<int> ages = ...;
+//   PackedIntArray packed_ages = PackedIntArray::BuildSmallest(ages);
+//   int age = packed_ages[5];
+//   std::vector<int> some_ages(1000);
+//   packed_ages.Decode(5000, absl::MakeSpan(some_ages));
+//
+// Random access with [] is a few shifts and masks for the first two, and
+// means decoding up to 127 values for kDeltaVarint. Decode() unpacks a run of
+// values at once and is much faster per value. The first two use AVX2 for
+// that when simd::ActiveSimdLevel() allows it (see simd_kernels.h), and the
+// running sum for kDeltaVarint uses simd::PrefixSum.
+//
+// The bits are read with unaligned little-endian loads, so this assumes a
+// little-endian CPU, which x86 and ARM both are in practice.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+
+class PackedIntArray {
+ public:
+  enum class Encoding { kFixedWidth, kFrameOfReference, kDeltaVarint };
+  static const char* EncodingName(Encoding encoding);
+
+  // An empty array.
+  PackedIntArray() = default;
+
+  static PackedIntArray Build(absl::Span<const int> values,
+                              Encoding encoding);
+  // Builds all three and keeps the smallest. Three times the work of Build.
+  static PackedIntArray BuildSmallest(absl::Span<const int> values);
+
+  Encoding encoding() const { return encoding_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  int operator[](size_t pos) const;
+
+  // Decodes out.size() values starting at `begin` into out.
+  void Decode(size_t begin, absl::Span<int> out) const;
+  std::vector<int> ToVector() const;
+
+  // Bytes of heap memory used. Compare against size() * sizeof(int).
+  size_t bytes_used() const {
+    return data_.capacity() + block_base_.capacity() * sizeof(uint32_t) +
+           block_offset_.capacity() * sizeof(uint64_t) +
+           block_width_.capacity();
+  }
+
+ private:
+  // kFrameOfReference blocks and kDeltaVarint restart points are this many
+  // values apart.
+  static constexpr size_t kBlockSize = 128;
+
+  void DecodeDeltaBlock(size_t block, size_t count, int* out) const;
+
+  Encoding encoding_ = Encoding::kFixedWidth;
+  size_t size_ = 0;
+
+  // kFixedWidth: value i is base_ plus the width_ bits starting at bit
+  // i * width_.
+  int width_ = 0;
+  uint32_t base_ = 0;
+
+  // The packed bits, or the varints, followed by some zero bytes so decoding
+  // can always load a whole word without running off the end.
+  std::vector<uint8_t> data_;
+
+  // One entry per block for the other two. block_base_ is the block's
+  // smallest value for kFrameOfReference and its first value for
+  // kDeltaVarint (which isn't in data_). block_offset_ is where the block
+  // starts in data_, and block_width_ the bits per value for
+  // kFrameOfReference.
+  std::vector<uint32_t> block_base_;
+  std::vector<uint64_t> block_offset_;
+  std::vector<uint8_t> block_width_;
+};
+
+#endif  // PACKED_INT_ARRAY_H_
@@ -0,0 +1,179 @@
+// PackedIntArray's encodings on a few int columns, for how small they get
+// and how fast they decode. Run with:
+//   bazel run -c opt :packed_int_array_bench
+//
+// compression_ratio is the size of the std::vector<int> divided by the size
+// of the PackedIntArray, and bits_per_value is the other way of saying the
+// same thing. BM_Decode reports GB/s of decoded ints written, so compare it
+// against BM_Copy, which is plain std::vector<int> copying the same number
+// of bytes. Decode runs with and without SIMD (the "scalar" runs).
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "packed_int_array.h"
+#include "simd_kernels.h"
+
+namespace {
+
+using Encoding = PackedIntArray::Encoding;
+using simd::SimdLevel;
+
+constexpr int64_t kSizes[] = {1 << 20, 16 << 20};
+constexpr int kNumQueries = 4096;
+
+enum class Column { kAges, kSortedIds, kRandomIds };
+const char* ColumnName(Column column) {
+  switch (column) {
+    case Column::kAges:
+      return "ages";
+    case Column::kSortedIds:
+      return "sorted_ids";
+    case Column::kRandomIds:
+      return "random_ids";
+  }
+  return "";
+}
+
+std::vector<int> MakeColumn(Column column, int64_t n) {
+  std::mt19937 rng(n);
+  std::vector<int> values(n);
+  switch (column) {
+    case Column::kAges: {
+      std::uniform_int_distribution<int> age(0, 100);
+      for (int& x : values) x = age(rng);
+      break;
+    }
+    case Column::kSortedIds: {
+      // Handed out in order, with some gaps where rows were deleted.
+      std::uniform_int_distribution<int> gap(1, 8);
+      int id = 1'000'000;
+      for (int& x : values) x = id += gap(rng);
+      break;
+    }
+    case Column::kRandomIds: {
+      std::uniform_int_distribution<int> id(0, (1 << 24) - 1);
+      for (int& x : values) x = id(rng);
+      break;
+    }
+  }
+  return values;
+}
+
+void SetSizeCounters(benchmark::State& state, const PackedIntArray& packed) {
+  const double bytes = packed.bytes_used();
+  state.counters["compression_ratio"] = packed.size() * sizeof(int) / bytes;
+  state.counters["bits_per_value"] = bytes * 8 / packed.size();
+}
+
+void BM_Decode(benchmark::State& state, Column column, Encoding encoding,
+               SimdLevel level) {
+  const int64_t n = state.range(0);
+  const PackedIntArray packed =
+      PackedIntArray::Build(MakeColumn(column, n), encoding);
+  std::vector<int> out(n);
+  simd::SetSimdLevel(level);
+  for (auto _ : state) {
+    packed.Decode(0, absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  simd::SetSimdLevel(simd::DetectedSimdLevel());
+  SetSizeCounters(state, packed);
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+
+void BM_Copy(benchmark::State& state, Column column) {
+  const int64_t n = state.range(0);
+  const std::vector<int> values = MakeColumn(column, n);
+  std::vector<int> out(n);
+  for (auto _ : state) {
+    std::copy(values.begin(), values.end(), out.begin());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+
+std::vector<size_t> MakeQueries(int64_t n) {
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<size_t> pos(0, n - 1);
+  std::vector<size_t> queries(kNumQueries);
+  for (size_t& q : queries) q = pos(rng);
+  return queries;
+}
+
+void BM_RandomAccess(benchmark::State& state, Column column,
+                     Encoding encoding) {
+  const int64_t n = state.range(0);
+  const PackedIntArray packed =
+      PackedIntArray::Build(MakeColumn(column, n), encoding);
+  const std::vector<size_t> queries = MakeQueries(n);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packed[queries[i++ % kNumQueries]]);
+  }
+  SetSizeCounters(state, packed);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RandomAccessVector(benchmark::State& state, Column column) {
+  const int64_t n = state.range(0);
+  const std::vector<int> values = MakeColumn(column, n);
+  const std::vector<size_t> queries = MakeQueries(n);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(values[queries[i++ % kNumQueries]]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void RegisterAll() {
+  const Encoding kEncodings[] = {Encoding::kFixedWidth,
+                                 Encoding::kFrameOfReference,
+                                 Encoding::kDeltaVarint};
+  std::vector<SimdLevel> levels = {SimdLevel::kScalar};
+  if (simd::DetectedSimdLevel() >= SimdLevel::kAvx2) {
+    levels.push_back(SimdLevel::kAvx2);
+  }
+  for (Column column :
+       {Column::kAges, Column::kSortedIds, Column::kRandomIds}) {
+    const std::string column_name = ColumnName(column);
+    auto* copy = benchmark::RegisterBenchmark(
+        ("BM_Copy/" + column_name + "/std::vector").c_str(), BM_Copy, column);
+    auto* vector_access = benchmark::RegisterBenchmark(
+        ("BM_RandomAccess/" + column_name + "/std::vector").c_str(),
+        BM_RandomAccessVector, column);
+    for (int64_t n : kSizes) {
+      copy->Arg(n);
+      vector_access->Arg(n);
+    }
+    for (Encoding encoding : kEncodings) {
+      const std::string name =
+          column_name + "/" + PackedIntArray::EncodingName(encoding);
+      for (SimdLevel level : levels) {
+        auto* decode = benchmark::RegisterBenchmark(
+            ("BM_Decode/" + name + "/" + simd::SimdLevelName(level)).c_str(),
+            BM_Decode, column, encoding, level);
+        for (int64_t n : kSizes) decode->Arg(n);
+      }
+      auto* access = benchmark::RegisterBenchmark(
+          ("BM_RandomAccess/" + name).c_str(), BM_RandomAccess, column,
+          encoding);
+      for (int64_t n : kSizes) access->Arg(n);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  RegisterAll();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,95 @@
+// Bulk container operations on one core vs spread over a ThreadPool. Run with:
+//   bazel run -c opt :parallel_bench
+//
+// The second argument is the number of pool threads. 0 is the plain serial
+// loop without the pool, for comparison. Anything above the number of cores
+// the machine has just adds overhead.
+
+#include <cstdint>
+#include <numeric>
+#include <set>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "parallel_sort.h"
+#include "thread_pool.h"
+
+namespace {
+
+// ThreadArgs() plus 0 threads for the serial loop.
+void SerialAndThreadArgs(benchmark::internal::Benchmark* b, int64_t size) {
+  b->Args({size, 0});
+  ThreadArgs(b, size);
+}
+
+// Summing nums_vector from Arrays(), 100M of them. This is memory bound, so
+// it stops scaling once the threads saturate memory bandwidth.
+void BM_SumNumsVector(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  const int threads = state.range(1);
+  std::vector<int> nums_vector(n);
+  std::iota(nums_vector.begin(), nums_vector.end(), 0);
+  for (auto _ : state) {
+    int64_t sum;
+    if (threads == 0) {
+      sum = std::accumulate(nums_vector.begin(), nums_vector.end(),
+                            int64_t{0});
+    } else {
+      sum = PoolWithThreads(threads).ParallelReduce(
+          0, n, int64_t{0},
+          [&](int64_t begin, int64_t end) {
+            return std::accumulate(&nums_vector[begin], &nums_vector[end],
+                                   int64_t{0});
+          },
+          [](int64_t a, int64_t b) { return a + b; });
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+BENCHMARK(BM_SumNumsVector)
+    ->Apply([](auto* b) { SerialAndThreadArgs(b, 100'000'000); })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Building an int_set from Trees() out of n keys in random order.
+//
+// A red-black tree can't be built from several threads at once, and building
+// separate sets and merge()ing them is slower than the serial loop since each
+// merge does a full lookup per node again. What does parallelize is sorting
+// the keys first: once they're sorted, inserting with end() as the hint is
+// O(1) per key instead of a walk down the tree with a cache miss per level.
+// So the parallel version sorts the keys on the pool with ParallelSort (see
+// parallel_sort.h), then builds the set in one serial pass.
+void BM_BuildIntSet(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  const int threads = state.range(1);
+  ScrambledOrder order(n);
+  std::vector<int> keys(n);
+  for (int64_t i = 0; i < n; ++i) keys[i] = MakeKey<int>(order[i]);
+  for (auto _ : state) {
+    std::set<int> int_set;
+    if (threads == 0) {
+      for (int key : keys) int_set.insert(key);
+    } else {
+      std::vector<int> sorted = keys;
+      ParallelSort(PoolWithThreads(threads), sorted.begin(), sorted.end());
+      for (int key : sorted) int_set.insert(int_set.end(), key);
+    }
+    benchmark::DoNotOptimize(int_set.size());
+    state.PauseTiming();
+    // Freeing 10M nodes isn't what's being measured.
+    int_set = std::set<int>();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_BuildIntSet)
+    ->Apply([](auto* b) { SerialAndThreadArgs(b, 10'000'000); })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,820 @@
+#ifndef PARALLEL_SORT_H_
+#define PARALLEL_SORT_H_
+
+// Sorting for big vectors, on one core (PdqSort) or all of them
+// (ParallelSort). Both take the same arguments as std::sort, so
+// Person::operator< and comparators like person_comp from main.cpp work
+// as-is:
+//
+//   std::vector<Person> people = ...;
+//   ParallelSort(people.begin(), people.end());  // by age
+//   auto person_comp = [](const Person& lhs, const Person& rhs) {
+//     return lhs.name < rhs.name;
+//   };
+//   ParallelSort(people.begin(), people.end(), person_comp);
+//
+// Like std::sort neither one is stable: people with the same age can come
+// out in any order.
+//
+// PdqSort is pattern-defeating quicksort (Orson Peters, 2021). It's an
+// introsort like std::sort, with a few extras that add up: input that's
+// already sorted, reverse sorted or has lots of equal keys gets done in about
+// linear time, and for ints (and other arithmetic types with the default
+// comparison) the partitioning is done without data-dependent branches, which
+// the CPU can't predict on random data. See "BlockQuicksort" by Edelkamp and
+// Weiss for that part.
+//
+// ParallelSort is a samplesort on a ThreadPool (ThreadPool::Default() unless
+// you pass one). It sorts a random sample of the input, picks up to 127 of
+// those as splitters, and then:
+//   1. Every thread takes a stripe of the input and works out which bucket
+//      (the range between two splitters) each element belongs in. The
+//      splitters are kept as an implicit binary tree, so that's 7 branch-free
+//      comparisons per element rather than a binary search full of
+//      mispredicted branches.
+//   2. The threads move the elements around inside the input until each
+//      bucket's elements are together, a block of about 2 KiB at a time.
+//   3. The buckets get sorted in parallel, recursively for the big ones and
+//      with PdqSort for the rest.
+// If the sample has repeated values (like ages), each repeated splitter also
+// gets a bucket of its own for elements equal to it, which is already sorted.
+// So lots of duplicates make this faster instead of slower.
+//
+// Step 2 is the in-place block distribution from IPS4o (Axtmann et al.), so
+// the extra memory doesn't grow with the input: a block per bucket per
+// thread, which is about 34 MB with 64 threads no matter whether it's sorting
+// a million Persons or 500 million, plus one byte per block.
+//
+// The comparator and moving elements must not throw, and ParallelSort also
+// needs the elements to be copyable (the splitters are copies).
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace parallel_sort_internal {
+
+// Ranges smaller than this get insertion sorted.
+constexpr ptrdiff_t kInsertionSortThreshold = 24;
+// Ranges bigger than this use the median of three medians as the pivot.
+constexpr ptrdiff_t kNintherThreshold = 128;
+// PartialInsertionSort gives up after moving elements this far in total.
+constexpr size_t kPartialInsertionSortLimit = 8;
+// Elements per round of the branchless partition. Offsets into a block have
+// to fit in an unsigned char.
+constexpr size_t kPartitionBlockSize = 64;
+
+template <typename Compare, typename T>
+constexpr bool kUseBranchlessPartition =
+    std::is_arithmetic_v<T> && (std::is_same_v<Compare, std::less<T>> ||
+                                std::is_same_v<Compare, std::less<>> ||
+                                std::is_same_v<Compare, std::greater<T>> ||
+                                std::is_same_v<Compare, std::greater<>>);
+
+template <typename Iter, typename Compare>
+void InsertionSort(Iter begin, Iter end, Compare& comp) {
+  if (begin == end) return;
+  for (Iter cur = begin + 1; cur != end; ++cur) {
+    Iter sift = cur;
+    Iter sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = std::move(*sift);
+      do {
+        *sift-- = std::move(*sift_1);
+      } while (sift != begin && comp(tmp, *--sift_1));
+      *sift = std::move(tmp);
+    }
+  }
+}
+
+// Same, but the element before `begin` is known to be <= everything in the
+// range, so the inner loop doesn't need to check for the start.
+template <typename Iter, typename Compare>
+void UnguardedInsertionSort(Iter begin, Iter end, Compare& comp) {
+  if (begin == end) return;
+  for (Iter cur = begin + 1; cur != end; ++cur) {
+    Iter sift = cur;
+    Iter sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = std::move(*sift);
+      do {
+        *sift-- = std::move(*sift_1);
+      } while (comp(tmp, *--sift_1));
+      *sift = std::move(tmp);
+    }
+  }
+}
+
+// Insertion sorts if that's cheap, which it is for nearly sorted ranges.
+// Returns false, leaving the range partly sorted, as soon as it has moved
+// more than kPartialInsertionSortLimit elements.
+template <typename Iter, typename Compare>
+bool PartialInsertionSort(Iter begin, Iter end, Compare& comp) {
+  if (begin == end) return true;
+  size_t moved = 0;
+  for (Iter cur = begin + 1; cur != end; ++cur) {
+    Iter sift = cur;
+    Iter sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = std::move(*sift);
+      do {
+        *sift-- = std::move(*sift_1);
+      } while (sift != begin && comp(tmp, *--sift_1));
+      *sift = std::move(tmp);
+      moved += cur - sift;
+      if (moved > kPartialInsertionSortLimit) return false;
+    }
+  }
+  return true;
+}
+
+template <typename Iter, typename Compare>
+void Sort2(Iter a, Iter b, Compare& comp) {
+  if (comp(*b, *a)) std::iter_swap(a, b);
+}
+
+template <typename Iter, typename Compare>
+void Sort3(Iter a, Iter b, Iter c, Compare& comp) {
+  Sort2(a, b, comp);
+  Sort2(b, c, comp);
+  Sort2(a, b, comp);
+}
+
+// Partitions [begin, end) around the pivot *begin: smaller elements to the
+// left, elements >= the pivot to the right. Returns where the pivot ended up
+// and whether the range was already partitioned (no swaps needed).
+template <typename Iter, typename Compare>
+std::pair<Iter, bool> PartitionRight(Iter begin, Iter end, Compare& comp) {
+  auto pivot = std::move(*begin);
+  Iter first = begin;
+  Iter last = end;
+  // The median-of-3 pivot selection guarantees there's an element >= the
+  // pivot, so this can't run off the end.
+  while (comp(*++first, pivot)) {
+  }
+  // If that was the first element, nothing guarantees an element < the
+  // pivot on the right.
+  if (first - 1 == begin) {
+    while (first < last && !comp(*--last, pivot)) {
+    }
+  } else {
+    while (!comp(*--last, pivot)) {
+    }
+  }
+  const bool already_partitioned = first >= last;
+  while (first < last) {
+    std::iter_swap(first, last);
+    while (comp(*++first, pivot)) {
+    }
+    while (!comp(*--last, pivot)) {
+    }
+  }
+  Iter pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// Swaps the elements at first + offsets_l[i] and last - offsets_r[i] for i
+// in [0, num). When both sides had the same number of misplaced elements
+// it does plain swaps, like the original. Otherwise it does a cyclic
+// permutation, which needs about a third fewer moves.
+template <typename Iter>
+void SwapOffsets(Iter first, Iter last, const unsigned char* offsets_l,
+                 const unsigned char* offsets_r, size_t num, bool use_swaps) {
+  if (use_swaps) {
+    for (size_t i = 0; i < num; ++i) {
+      std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+    }
+  } else if (num > 0) {
+    Iter l = first + offsets_l[0];
+    Iter r = last - offsets_r[0];
+    auto tmp = std::move(*l);
+    *l = std::move(*r);
+    for (size_t i = 1; i < num; ++i) {
+      l = first + offsets_l[i];
+      *r = std::move(*l);
+      r = last - offsets_r[i];
+      *l = std::move(*r);
+    }
+    *r = std::move(tmp);
+  }
+}
+
+// PartitionRight without branches that depend on the comparisons. Each
+// round scans a block from both ends and records the offsets of the elements
+// on the wrong side, using the comparison result as a number to add instead
+// of an if. Then it swaps those pairs.
+template <typename Iter, typename Compare>
+std::pair<Iter, bool> PartitionRightBranchless(Iter begin, Iter end,
+                                               Compare& comp) {
+  auto pivot = std::move(*begin);
+  Iter first = begin;
+  Iter last = end;
+  while (comp(*++first, pivot)) {
+  }
+  if (first - 1 == begin) {
+    while (first < last && !comp(*--last, pivot)) {
+    }
+  } else {
+    while (!comp(*--last, pivot)) {
+    }
+  }
+  const bool already_partitioned = first >= last;
+  if (!already_partitioned) {
+    std::iter_swap(first, last);
+    ++first;
+
+    alignas(64) unsigned char offsets_l_storage[kPartitionBlockSize];
+    alignas(64) unsigned char offsets_r_storage[kPartitionBlockSize];
+    unsigned char* offsets_l = offsets_l_storage;
+    unsigned char* offsets_r = offsets_r_storage;
+    Iter offsets_l_base = first;
+    Iter offsets_r_base = last;
+    size_t num_l = 0;
+    size_t num_r = 0;
+    size_t start_l = 0;
+    size_t start_r = 0;
+    while (first < last) {
+      // Refill whichever offset blocks are empty, splitting what's left
+      // between them.
+      const size_t num_unknown = last - first;
+      const size_t left_split =
+          num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+      const size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+      const size_t left_count = std::min(left_split, kPartitionBlockSize);
+      for (size_t i = 0; i < left_count; ++i) {
+        offsets_l[num_l] = static_cast<unsigned char>(i);
+        num_l += !comp(*first, pivot);
+        ++first;
+      }
+      const size_t right_count = std::min(right_split, kPartitionBlockSize);
+      for (size_t i = 0; i < right_count; ++i) {
+        offsets_r[num_r] = static_cast<unsigned char>(i + 1);
+        num_r += comp(*--last, pivot);
+      }
+
+      const size_t num = std::min(num_l, num_r);
+      SwapOffsets(offsets_l_base, offsets_r_base, offsets_l + start_l,
+                  offsets_r + start_r, num, num_l == num_r);
+      num_l -= num;
+      num_r -= num;
+      start_l += num;
+      start_r += num;
+      if (num_l == 0) {
+        start_l = 0;
+        offsets_l_base = first;
+      }
+      if (num_r == 0) {
+        start_r = 0;
+        offsets_r_base = last;
+      }
+    }
+
+    // Everything has been looked at. Whatever's left over on one side goes
+    // to the boundary.
+    if (num_l > 0) {
+      offsets_l += start_l;
+      while (num_l-- > 0) {
+        std::iter_swap(offsets_l_base + offsets_l[num_l], --last);
+      }
+      first = last;
+    }
+    if (num_r > 0) {
+      offsets_r += start_r;
+      while (num_r-- > 0) {
+        std::iter_swap(offsets_r_base - offsets_r[num_r], first);
+        ++first;
+      }
+      last = first;
+    }
+  }
+  Iter pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// Partitions with elements equal to the pivot going left. Used when the
+// pivot equals the element just before the range, which means every element
+// equal to it is already in the right place once they're grouped together.
+template <typename Iter, typename Compare>
+Iter PartitionLeft(Iter begin, Iter end, Compare& comp) {
+  auto pivot = std::move(*begin);
+  Iter first = begin;
+  Iter last = end;
+  while (comp(pivot, *--last)) {
+  }
+  if (last + 1 == end) {
+    while (first < last && !comp(pivot, *++first)) {
+    }
+  } else {
+    while (!comp(pivot, *++first)) {
+    }
+  }
+  while (first < last) {
+    std::iter_swap(first, last);
+    while (comp(pivot, *--last)) {
+    }
+    while (!comp(pivot, *++first)) {
+    }
+  }
+  Iter pivot_pos = last;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return pivot_pos;
+}
+
+// `bad_allowed` is how many more badly unbalanced partitions are tolerated
+// before giving up on quicksort and heapsorting the range. `leftmost` is
+// false when there's an element before `begin` that's <= everything in the
+// range.
+template <bool kBranchless, typename Iter, typename Compare>
+void PdqSortLoop(Iter begin, Iter end, Compare& comp, int bad_allowed,
+                 bool leftmost) {
+  while (true) {
+    const ptrdiff_t size = end - begin;
+    if (size < kInsertionSortThreshold) {
+      if (leftmost) {
+        InsertionSort(begin, end, comp);
+      } else {
+        UnguardedInsertionSort(begin, end, comp);
+      }
+      return;
+    }
+
+    // Median of 3 for the pivot, or the median of three medians of 3 for
+    // big ranges. Either way it ends up at *begin.
+    const ptrdiff_t half = size / 2;
+    if (size > kNintherThreshold) {
+      Sort3(begin, begin + half, end - 1, comp);
+      Sort3(begin + 1, begin + (half - 1), end - 2, comp);
+      Sort3(begin + 2, begin + (half + 1), end - 3, comp);
+      Sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+      std::iter_swap(begin, begin + half);
+    } else {
+      Sort3(begin + half, begin, end - 1, comp);
+    }
+
+    // If the pivot equals the element before the range, no element in the
+    // range is smaller than it. Group the equal ones on the left, and they're
+    // done.
+    if (!leftmost && !comp(*(begin - 1), *begin)) {
+      begin = PartitionLeft(begin, end, comp) + 1;
+      continue;
+    }
+
+    const auto [pivot_pos, already_partitioned] =
+        kBranchless ? PartitionRightBranchless(begin, end, comp)
+                    : PartitionRight(begin, end, comp);
+    const ptrdiff_t l_size = pivot_pos - begin;
+    const ptrdiff_t r_size = end - (pivot_pos + 1);
+    const bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+    if (highly_unbalanced) {
+      // Too many bad pivots means the input is attacking us. Heapsort is
+      // O(n log n) no matter what.
+      if (--bad_allowed == 0) {
+        std::make_heap(begin, end, comp);
+        std::sort_heap(begin, end, comp);
+        return;
+      }
+      // Otherwise shuffle some elements around to break up whatever pattern
+      // caused it.
+      if (l_size >= kInsertionSortThreshold) {
+        std::iter_swap(begin, begin + l_size / 4);
+        std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+        if (l_size > kNintherThreshold) {
+          std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+          std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+          std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+          std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+        }
+      }
+      if (r_size >= kInsertionSortThreshold) {
+        std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+        std::iter_swap(end - 1, end - r_size / 4);
+        if (r_size > kNintherThreshold) {
+          std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+          std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+          std::iter_swap(end - 2, end - (1 + r_size / 4));
+          std::iter_swap(end - 3, end - (2 + r_size / 4));
+        }
+      }
+    } else if (already_partitioned &&
+               PartialInsertionSort(begin, pivot_pos, comp) &&
+               PartialInsertionSort(pivot_pos + 1, end, comp)) {
+      // A well-balanced partition that didn't swap anything probably means
+      // the input was already sorted, so try finishing with insertion sort.
+      return;
+    }
+
+    // Recurse on the left, loop on the right.
+    PdqSortLoop<kBranchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+    begin = pivot_pos + 1;
+    leftmost = false;
+  }
+}
+
+// Ranges below this are sorted with PdqSort instead of being split up
+// further.
+constexpr ptrdiff_t kParallelThreshold = 1 << 16;
+// Most splitters per samplesort step. 127 splitters and their equal
+// buckets make 255 bucket ids, which fit in a byte.
+constexpr size_t kMaxBuckets = 128;
+// How many sample elements per bucket. More gives more even buckets.
+constexpr size_t kOversampling = 16;
+// Buckets that come out at least this fraction of their parent are a sign
+// the sample was unlucky. Recursing on them again is fine, but only a few
+// times.
+constexpr int kMaxDepth = 4;
+// Elements get moved between buckets in blocks of about this many bytes.
+constexpr size_t kBlockBytes = 2048;
+// A stripe buffers up to a block per bucket. Stripes are made at least this
+// many times bigger than that, so the buffers are never more than a quarter
+// of the range being sorted.
+constexpr ptrdiff_t kMinStripeBlocksPerBucket = 4;
+
+// What's in each block-sized slot of the range while the blocks are being
+// moved to their buckets.
+enum SlotState : uint8_t { kEmpty, kFull, kReading, kPlaced };
+
+// Everything a samplesort step needs, shared across the recursion.
+template <typename Iter, typename Compare>
+struct SampleSorter {
+  using T = typename std::iterator_traits<Iter>::value_type;
+  static constexpr ptrdiff_t kBlockSize =
+      std::max<ptrdiff_t>(1, kBlockBytes / sizeof(T));
+
+  ThreadPool& pool;
+  Compare& comp;
+
+  void Sort(Iter begin, Iter end, int depth);
+  void SortBucket(Iter begin, Iter end, int depth, ptrdiff_t parent_size);
+  template <typename Classify>
+  std::vector<ptrdiff_t> Distribute(Iter begin, Iter end, size_t num_ids,
+                                    const Classify& classify);
+};
+
+// PdqSort's body. It has a different name so that calls from in here can't
+// pick up the public PdqSort through argument-dependent lookup.
+template <typename Iter, typename Compare>
+void SequentialSort(Iter begin, Iter end, Compare& comp) {
+  using T = typename std::iterator_traits<Iter>::value_type;
+  if (end - begin < 2) return;
+  int log2_size = 0;
+  for (auto size = end - begin; size > 1; size >>= 1) ++log2_size;
+  PdqSortLoop<kUseBranchlessPartition<Compare, T>>(begin, end, comp,
+                                                   log2_size, true);
+}
+
+// One samplesort step over [begin, end).
+template <typename Iter, typename Compare>
+void SampleSorter<Iter, Compare>::Sort(Iter begin, Iter end, int depth) {
+  const ptrdiff_t n = end - begin;
+  if (n < kParallelThreshold || depth > kMaxDepth) {
+    SequentialSort(begin, end, comp);
+    return;
+  }
+
+  // Pick the splitters from a sorted random sample. Fewer buckets for
+  // smaller ranges so they don't end up tiny.
+  size_t num_buckets = 2;
+  while (num_buckets < kMaxBuckets &&
+         static_cast<ptrdiff_t>(num_buckets * 2) * 4096 <= n) {
+    num_buckets *= 2;
+  }
+  std::mt19937_64 rng(n + depth);
+  std::uniform_int_distribution<ptrdiff_t> any_index(0, n - 1);
+  std::vector<T> sample;
+  sample.reserve(num_buckets * kOversampling);
+  for (size_t i = 0; i < num_buckets * kOversampling; ++i) {
+    sample.push_back(begin[any_index(rng)]);
+  }
+  SequentialSort(sample.begin(), sample.end(), comp);
+  std::vector<T> splitters;
+  for (size_t i = 1; i < num_buckets; ++i) {
+    const T& candidate = sample[i * kOversampling - 1];
+    if (splitters.empty() || comp(splitters.back(), candidate)) {
+      splitters.push_back(candidate);
+    }
+  }
+  const bool use_equal_buckets = splitters.size() < num_buckets - 1;
+  // The tree needs a power of two minus one splitters. Padding with copies of
+  // the last one just makes some buckets that stay empty.
+  size_t num_leaves = 2;
+  while (num_leaves - 1 < splitters.size()) num_leaves *= 2;
+  splitters.resize(num_leaves - 1, splitters.back());
+
+  // tree[1] is the middle splitter, tree[2] and tree[3] the middles of each
+  // half, and so on, so the children of node j are 2j and 2j + 1.
+  std::vector<T> tree(num_leaves, splitters[0]);
+  auto build = [&](auto& self, size_t node, size_t lo, size_t hi) -> void {
+    const size_t mid = lo + (hi - lo) / 2;
+    tree[node] = splitters[mid];
+    if (hi - lo > 1) {
+      self(self, 2 * node, lo, mid);
+      self(self, 2 * node + 1, mid + 1, hi);
+    }
+  };
+  build(build, 1, 0, splitters.size());
+  int levels = 0;
+  while ((size_t{1} << levels) < num_leaves) ++levels;
+  // With equal buckets, bucket 2b is the range between splitters b - 1 and
+  // b, and 2b + 1 is elements equal to splitter b.
+  const size_t num_ids = use_equal_buckets ? 2 * num_leaves - 1 : num_leaves;
+  auto classify = [&](const T& value) -> uint8_t {
+    size_t node = 1;
+    for (int level = 0; level < levels; ++level) {
+      node = 2 * node + !comp(value, tree[node]);
+    }
+    // How many splitters are <= value.
+    const size_t leaf = node - num_leaves;
+    if (!use_equal_buckets) return static_cast<uint8_t>(leaf);
+    const bool equal = leaf > 0 && !comp(splitters[leaf - 1], value);
+    return static_cast<uint8_t>(2 * leaf - equal);
+  };
+
+  const std::vector<ptrdiff_t> bucket_starts =
+      Distribute(begin, end, num_ids, classify);
+
+  // Sort the buckets. Equal buckets are already sorted.
+  pool.ParallelFor(0, num_ids, 1, [&](int64_t first, int64_t last) {
+    for (int64_t id = first; id < last; ++id) {
+      if (use_equal_buckets && id % 2 == 1) continue;
+      SortBucket(begin + bucket_starts[id], begin + bucket_starts[id + 1],
+                 depth, n);
+    }
+  });
+}
+
+// Moves the elements of [begin, end) so that each bucket's elements are
+// together and the buckets are in order of id, and returns where each one
+// starts, plus n at the end. This is the block distribution from IPS4o
+// (Axtmann, Witt, Ferizovic and Sanders, "In-Place Parallel Super Scalar
+// Samplesort", 2017), a bit simplified:
+//   1. Every thread takes a stripe of the range, which is a whole number of
+//      blocks, and classifies its elements into a small buffer per bucket.
+//      A buffer that fills up gets written back over the start of the
+//      stripe, which has already been read, as a full block. That leaves
+//      each stripe with some full blocks at its start and up to a block per
+//      bucket still in its buffers.
+//   2. The bucket sizes say where each bucket's blocks have to go: the block
+//      slots from where the bucket starts, rounded up. The threads pick up
+//      full blocks and carry each one to the next free slot of its bucket.
+//      If there's a full block in that slot they take it with them and carry
+//      it on in turn. A state per slot makes sure that nobody overwrites a
+//      block before it has been picked up.
+//   3. What's left is the part of each bucket before its first block, and
+//      after its last block if it ends in the middle of one. Those get filled
+//      from the stripe buffers, and from the end of the bucket's last block
+//      if that stuck out into the next bucket.
+// The extra memory is the buffers, which are at most (threads + 1) *
+// buckets * kBlockBytes, plus a byte per block for the slot states.
+template <typename Iter, typename Compare>
+template <typename Classify>
+std::vector<ptrdiff_t> SampleSorter<Iter, Compare>::Distribute(
+    Iter begin, Iter end, size_t num_ids, const Classify& classify) {
+  constexpr ptrdiff_t kBlock = kBlockSize;
+  const ptrdiff_t n = end - begin;
+  const ptrdiff_t num_slots = (n + kBlock - 1) / kBlock;
+  const ptrdiff_t num_stripes = std::max<ptrdiff_t>(
+      1, std::min<ptrdiff_t>(
+             pool.num_threads() + 1,
+             n / (kMinStripeBlocksPerBucket * kBlock *
+                  static_cast<ptrdiff_t>(num_ids))));
+  const ptrdiff_t stripe_size =
+      (num_slots + num_stripes - 1) / num_stripes * kBlock;
+
+  // Everything gets allocated up front, since the functions run on the pool
+  // can't throw.
+  struct Stripe {
+    // One per bucket, each with room for a block.
+    std::vector<std::vector<T>> buffers;
+    std::vector<ptrdiff_t> counts;
+    // Full blocks are [start, full_end).
+    ptrdiff_t start = 0;
+    ptrdiff_t full_end = 0;
+    // For carrying blocks around in step 2.
+    std::vector<T> hand;
+    std::vector<T> spare;
+  };
+  std::vector<Stripe> stripes(num_stripes);
+  for (Stripe& stripe : stripes) {
+    stripe.buffers.resize(num_ids);
+    for (std::vector<T>& buffer : stripe.buffers) buffer.reserve(kBlock);
+    stripe.counts.assign(num_ids, 0);
+    stripe.hand.reserve(kBlock);
+    stripe.spare.reserve(kBlock);
+  }
+  std::vector<std::atomic<uint8_t>> states(num_slots);
+  std::vector<std::atomic<ptrdiff_t>> next_slot(num_ids);
+  // Where the blocks go if one lands in the last slot and it's only partly
+  // inside the range.
+  std::vector<T> overflow;
+  overflow.reserve(kBlock);
+  // The end of a bucket's last block, where it sticks out into the next.
+  std::vector<std::vector<T>> sticking_out(num_ids);
+  for (std::vector<T>& elements : sticking_out) elements.reserve(kBlock);
+
+  // 1. Classify the stripes into blocks.
+  pool.ParallelFor(0, num_stripes, 1, [&](int64_t first, int64_t last) {
+    for (int64_t s = first; s < last; ++s) {
+      Stripe& stripe = stripes[s];
+      stripe.start = std::min(n, s * stripe_size);
+      const ptrdiff_t stop = std::min(n, (s + 1) * stripe_size);
+      ptrdiff_t write = stripe.start;
+      for (ptrdiff_t i = stripe.start; i < stop; ++i) {
+        const uint8_t id = classify(begin[i]);
+        ++stripe.counts[id];
+        std::vector<T>& buffer = stripe.buffers[id];
+        buffer.push_back(std::move(begin[i]));
+        if (static_cast<ptrdiff_t>(buffer.size()) == kBlock) {
+          std::move(buffer.begin(), buffer.end(), begin + write);
+          buffer.clear();
+          write += kBlock;
+        }
+      }
+      stripe.full_end = write;
+    }
+  });
+
+  // Work out where the buckets start, and how many full blocks each has.
+  std::vector<ptrdiff_t> bucket_starts(num_ids + 1);
+  std::vector<ptrdiff_t> full_blocks(num_ids);
+  ptrdiff_t total = 0;
+  for (size_t id = 0; id < num_ids; ++id) {
+    bucket_starts[id] = total;
+    ptrdiff_t buffered = 0;
+    for (const Stripe& stripe : stripes) {
+      total += stripe.counts[id];
+      buffered += stripe.buffers[id].size();
+    }
+    full_blocks[id] = (total - bucket_starts[id] - buffered) / kBlock;
+    next_slot[id].store((bucket_starts[id] + kBlock - 1) / kBlock,
+                        std::memory_order_relaxed);
+  }
+  bucket_starts[num_ids] = total;
+  for (ptrdiff_t slot = 0; slot < num_slots; ++slot) {
+    states[slot].store(kEmpty, std::memory_order_relaxed);
+  }
+  for (const Stripe& stripe : stripes) {
+    for (ptrdiff_t i = stripe.start; i < stripe.full_end; i += kBlock) {
+      states[i / kBlock].store(kFull, std::memory_order_relaxed);
+    }
+  }
+
+  // 2. Move the full blocks to their buckets.
+  pool.ParallelFor(0, num_stripes, 1, [&](int64_t first, int64_t last) {
+    for (int64_t s = first; s < last; ++s) {
+      Stripe& stripe = stripes[s];
+      std::vector<T>* hand = &stripe.hand;
+      std::vector<T>* spare = &stripe.spare;
+      for (ptrdiff_t i = stripe.start; i < stripe.full_end; i += kBlock) {
+        uint8_t state = kFull;
+        if (!states[i / kBlock].compare_exchange_strong(
+                state, kReading, std::memory_order_acquire)) {
+          // Somebody else already picked it up.
+          continue;
+        }
+        std::move(begin + i, begin + i + kBlock, std::back_inserter(*hand));
+        states[i / kBlock].store(kEmpty, std::memory_order_release);
+        while (true) {
+          const ptrdiff_t slot = next_slot[classify(hand->front())].fetch_add(
+              1, std::memory_order_relaxed);
+          const ptrdiff_t slot_begin = slot * kBlock;
+          // Nobody else writes to this slot, but it might have a block in it
+          // that has to be picked up first, by us or whoever got there first.
+          bool picked_up = false;
+          state = states[slot].load(std::memory_order_acquire);
+          while (state != kEmpty) {
+            if (state == kFull) {
+              if (states[slot].compare_exchange_weak(
+                      state, kReading, std::memory_order_acquire)) {
+                std::move(begin + slot_begin, begin + slot_begin + kBlock,
+                          std::back_inserter(*spare));
+                picked_up = true;
+                break;
+              }
+            } else {
+              std::this_thread::yield();
+              state = states[slot].load(std::memory_order_acquire);
+            }
+          }
+          if (slot_begin + kBlock > n) {
+            overflow.swap(*hand);
+          } else {
+            std::move(hand->begin(), hand->end(), begin + slot_begin);
+          }
+          hand->clear();
+          states[slot].store(kPlaced, std::memory_order_release);
+          if (!picked_up) break;
+          std::swap(hand, spare);
+        }
+      }
+    }
+  });
+
+  // 3. Fill in the gaps around each bucket's blocks. First save whatever
+  // sticks out into the next bucket, since that one is about to be
+  // overwritten.
+  auto blocks_begin = [&](size_t id) {
+    return (bucket_starts[id] + kBlock - 1) / kBlock * kBlock;
+  };
+  pool.ParallelFor(0, num_ids, 1, [&](int64_t first, int64_t last) {
+    for (int64_t id = first; id < last; ++id) {
+      const ptrdiff_t bucket_end = bucket_starts[id + 1];
+      const ptrdiff_t blocks_end = blocks_begin(id) + full_blocks[id] * kBlock;
+      if (full_blocks[id] == 0 || blocks_end <= bucket_end) continue;
+      if (blocks_end > n) {
+        // The last block went to overflow.
+        const ptrdiff_t inside = n - (blocks_end - kBlock);
+        std::move(overflow.begin(), overflow.begin() + inside,
+                  begin + (blocks_end - kBlock));
+        std::move(overflow.begin() + inside, overflow.end(),
+                  std::back_inserter(sticking_out[id]));
+      } else {
+        std::move(begin + bucket_end, begin + blocks_end,
+                  std::back_inserter(sticking_out[id]));
+      }
+    }
+  });
+  pool.ParallelFor(0, num_ids, 1, [&](int64_t first, int64_t last) {
+    for (int64_t id = first; id < last; ++id) {
+      const ptrdiff_t bucket_end = bucket_starts[id + 1];
+      // The gaps are [pos, gap_end) and [tail_begin, bucket_end).
+      ptrdiff_t pos = bucket_starts[id];
+      ptrdiff_t gap_end = bucket_end;
+      ptrdiff_t tail_begin = bucket_end;
+      if (full_blocks[id] > 0) {
+        gap_end = blocks_begin(id);
+        tail_begin = std::min(bucket_end, gap_end + full_blocks[id] * kBlock);
+      }
+      auto fill_from = [&](std::vector<T>& elements) {
+        for (T& value : elements) {
+          if (pos == gap_end) pos = tail_begin;
+          begin[pos++] = std::move(value);
+        }
+      };
+      fill_from(sticking_out[id]);
+      for (Stripe& stripe : stripes) fill_from(stripe.buffers[id]);
+    }
+  });
+  return bucket_starts;
+}
+
+template <typename Iter, typename Compare>
+void SampleSorter<Iter, Compare>::SortBucket(Iter begin, Iter end, int depth,
+                                             ptrdiff_t parent_size) {
+  // A bucket holding most of its parent didn't get split much, so count
+  // towards the depth limit faster.
+  const bool badly_split = (end - begin) > parent_size / 2;
+  Sort(begin, end, depth + (badly_split ? 2 : 1));
+}
+
+}  // namespace parallel_sort_internal
+
+template <typename Iter, typename Compare>
+void PdqSort(Iter begin, Iter end, Compare comp) {
+  parallel_sort_internal::SequentialSort(begin, end, comp);
+}
+template <typename Iter>
+void PdqSort(Iter begin, Iter end) {
+  PdqSort(begin, end, std::less<>());
+}
+
+template <typename Iter, typename Compare>
+void ParallelSort(ThreadPool& pool, Iter begin, Iter end, Compare comp) {
+  const ptrdiff_t n = end - begin;
+  if (n < parallel_sort_internal::kParallelThreshold ||
+      pool.num_threads() <= 1) {
+    parallel_sort_internal::SequentialSort(begin, end, comp);
+    return;
+  }
+  parallel_sort_internal::SampleSorter<Iter, Compare> sorter{pool, comp};
+  sorter.Sort(begin, end, 0);
+}
+template <typename Iter>
+void ParallelSort(ThreadPool& pool, Iter begin, Iter end) {
+  ParallelSort(pool, begin, end, std::less<>());
+}
+template <typename Iter, typename Compare>
+void ParallelSort(Iter begin, Iter end, Compare comp) {
+  ParallelSort(ThreadPool::Default(), begin, end, comp);
+}
+template <typename Iter>
+void ParallelSort(Iter begin, Iter end) {
+  ParallelSort(begin, end, std::less<>());
+}
+
+#endif  // PARALLEL_SORT_H_
@@ -0,0 +1,104 @@
+// PdqSort and ParallelSort against std::sort and std::stable_sort. Run with:
+//   bazel run -c opt :parallel_sort_bench
+//
+// Sorts vector<int> and vector<Person>, the Persons both by age with
+// Person::operator< (only ~100 different keys) and by name with
+// PersonNameLess, person_comp from main.cpp. The ParallelSort argument is the
+// number of pool threads.
+// Anything above the number of cores the machine has just adds overhead.
+//
+// Sizes are kept small enough to run in a few minutes. Sorting scales about
+// like n log n from here, and the extra memory ParallelSort uses stays the
+// same.
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "parallel_sort.h"
+#include "person.h"
+#include "thread_pool.h"
+
+namespace {
+
+constexpr int64_t kNumInts = 20'000'000;
+constexpr int64_t kNumPeople = 4'000'000;
+
+// What gets sorted, and how. Each has the unsorted input and the comparator.
+struct Ints {
+  static std::vector<int> Make(int64_t n) {
+    std::mt19937 rng(n);
+    std::vector<int> nums_vector(n);
+    for (int& x : nums_vector) x = static_cast<int>(rng());
+    return nums_vector;
+  }
+  static constexpr std::less<> comp{};
+};
+
+struct PeopleByAge {
+  static std::vector<Person> Make(int64_t n) { return MakePeople(n); }
+  static constexpr std::less<> comp{};
+};
+
+struct PeopleByName {
+  static std::vector<Person> Make(int64_t n) { return MakePeople(n); }
+  static constexpr PersonNameLess comp{};
+};
+
+template <typename Kind>
+void BM_StdSort(benchmark::State& state) {
+  RunSort(state, Kind::Make(state.range(0)), [](auto& values) {
+    std::sort(values.begin(), values.end(), Kind::comp);
+  });
+}
+
+template <typename Kind>
+void BM_StdStableSort(benchmark::State& state) {
+  RunSort(state, Kind::Make(state.range(0)), [](auto& values) {
+    std::stable_sort(values.begin(), values.end(), Kind::comp);
+  });
+}
+
+template <typename Kind>
+void BM_PdqSort(benchmark::State& state) {
+  RunSort(state, Kind::Make(state.range(0)), [](auto& values) {
+    PdqSort(values.begin(), values.end(), Kind::comp);
+  });
+}
+
+template <typename Kind>
+void BM_ParallelSort(benchmark::State& state) {
+  ThreadPool& pool = PoolWithThreads(state.range(1));
+  RunSort(state, Kind::Make(state.range(0)), [&pool](auto& values) {
+    ParallelSort(pool, values.begin(), values.end(), Kind::comp);
+  });
+}
+
+#define SORT_BENCHMARKS(Kind, size)                                   \
+  BENCHMARK_TEMPLATE(BM_StdSort, Kind)                                \
+      ->Arg(size)                                                     \
+      ->UseRealTime()                                                 \
+      ->Unit(benchmark::kMillisecond);                                \
+  BENCHMARK_TEMPLATE(BM_StdStableSort, Kind)                          \
+      ->Arg(size)                                                     \
+      ->UseRealTime()                                                 \
+      ->Unit(benchmark::kMillisecond);                                \
+  BENCHMARK_TEMPLATE(BM_PdqSort, Kind)                                \
+      ->Arg(size)                                                     \
+      ->UseRealTime()                                                 \
+      ->Unit(benchmark::kMillisecond);                                \
+  BENCHMARK_TEMPLATE(BM_ParallelSort, Kind)                           \
+      ->Apply([](auto* b) { ThreadArgs(b, size); })                   \
+      ->UseRealTime()                                                 \
+      ->Unit(benchmark::kMillisecond)
+
+SORT_BENCHMARKS(Ints, kNumInts);
+SORT_BENCHMARKS(PeopleByAge, kNumPeople);
+SORT_BENCHMARKS(PeopleByName, kNumPeople);
+
+}  // namespace
+
+BENCHMARK_MAIN();
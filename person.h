@@ -0,0 +1,35 @@
+#ifndef PERSON_H_
+#define PERSON_H_
+
+#include <functional>
+#include <string>
+
+struct Person {
+  std::string name;
+  int age;
+  bool operator<(const Person& rhs) const { return age < rhs.age; }
+};
+
+// Named versions of the hash_fn/eq_fn lambdas in HashTables() and of
+// person_comp in main.cpp. Lambdas are a pain to use as template arguments
+// outside of the function they're declared in, so anything that needs an
+// unordered_set<Person> or to order people by name elsewhere uses these.
+struct PersonNameHash {
+  size_t operator()(const Person& person) const {
+    return std::hash<std::string>{}(person.name);
+  }
+};
+
+struct PersonNameEq {
+  bool operator()(const Person& lhs, const Person& rhs) const {
+    return lhs.name == rhs.name;
+  }
+};
+
+struct PersonNameLess {
+  bool operator()(const Person& lhs, const Person& rhs) const {
+    return lhs.name < rhs.name;
+  }
+};
+
+#endif  // PERSON_H_
@@ -0,0 +1,136 @@
+// Throughput and memory use of the pmr containers with each kind of memory
+// resource. Run with:
+//   bazel run -c opt :pmr_bench
+//
+// The first argument is the MemoryResourceKind, the second is the number of
+// elements per container. Each iteration builds a container and destroys it,
+// like one request would. The monotonic resource gets Release()d after every
+// iteration since it never reuses memory otherwise. The pools are left alone
+// so they can reuse their free lists, which is how you'd use them for real.
+//
+// Two memory counters are reported, both relative to RSS when the benchmark
+// started:
+//   rss_peak: while one full container is alive.
+//   rss_retained: after the timing loop, with the containers gone but the
+//     resource still alive. This is memory the pools hang on to.
+// RSS is per process, so an earlier benchmark can leave memory lying around
+// in malloc that makes a later one look cheaper. Use --benchmark_filter to run
+// one at a time when you care about exact numbers.
+
+#include <cstdint>
+#include <string>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "memory_stats.h"
+#include "person.h"
+#include "pmr_containers.h"
+
+namespace {
+
+template <typename C>
+void Fill(C& c, int64_t n) {
+  using Value = typename C::value_type;
+  if constexpr (std::is_same_v<C, PmrNums>) {
+    for (int64_t i = 0; i < n; ++i) c.push_back(static_cast<int>(i));
+  } else if constexpr (std::is_same_v<Value, int>) {
+    ScrambledOrder order(n);
+    for (int64_t i = 0; i < n; ++i) c.insert(static_cast<int>(order[i]));
+  } else if constexpr (std::is_same_v<Value, Person>) {
+    for (int64_t i = 0; i < n; ++i) c.insert(MakeKey<Person>(i));
+  } else if constexpr (std::is_same_v<Value, std::pmr::string>) {
+    // Long enough to not fit in the small string buffer, so the string
+    // memory comes from the resource too.
+    for (int64_t i = 0; i < n; ++i) {
+      c.insert(Value("person_name_" + MakeKey<std::string>(i)));
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      c.emplace("person_name_" + MakeKey<std::string>(i), 40);
+    }
+  }
+}
+
+void SetLabel(benchmark::State& state, MemoryResourceKind kind) {
+  state.SetLabel(MemoryResourceName(kind));
+}
+
+template <typename C>
+void BM_BuildAndDestroy(benchmark::State& state) {
+  const auto kind = static_cast<MemoryResourceKind>(state.range(0));
+  const int64_t n = state.range(1);
+  const int64_t rss_start = CurrentRssBytes();
+  PmrResource resource(kind);
+
+  // One untimed build just to see how much memory a full container takes.
+  int64_t rss_peak;
+  {
+    C c(resource.get());
+    Fill(c, n);
+    rss_peak = CurrentRssBytes() - rss_start;
+  }
+  if (kind == MemoryResourceKind::kMonotonic) resource.Release();
+
+  for (auto _ : state) {
+    {
+      C c(resource.get());
+      Fill(c, n);
+      benchmark::DoNotOptimize(c.size());
+    }
+    if (kind == MemoryResourceKind::kMonotonic) resource.Release();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.counters["rss_peak"] = rss_peak;
+  state.counters["rss_retained"] = CurrentRssBytes() - rss_start;
+  SetLabel(state, kind);
+}
+
+void AllResources(benchmark::internal::Benchmark* b) {
+  for (auto kind :
+       {MemoryResourceKind::kNewDelete, MemoryResourceKind::kMonotonic,
+        MemoryResourceKind::kUnsynchronizedPool,
+        MemoryResourceKind::kSynchronizedPool}) {
+    for (int64_t n : {64, 4096, 262144}) {
+      b->Args({static_cast<int64_t>(kind), n});
+    }
+  }
+  b->ArgNames({"resource", "n"});
+}
+
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrNums)->Apply(AllResources);
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrIntSet)->Apply(AllResources);
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrAges)->Apply(AllResources);
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrUnorderedAges)->Apply(AllResources);
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrPeopleSet)->Apply(AllResources);
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrNames)->Apply(AllResources);
+BENCHMARK_TEMPLATE(BM_BuildAndDestroy, PmrUnorderedNames)
+    ->Apply(AllResources);
+
+// Only new/delete and the synchronized pool are safe to share between
+// threads. Every thread builds its own PmrAges out of one shared resource.
+void BM_SharedResource(benchmark::State& state) {
+  const auto kind = static_cast<MemoryResourceKind>(state.range(0));
+  static PmrResource new_delete(MemoryResourceKind::kNewDelete);
+  static PmrResource synchronized_pool(MemoryResourceKind::kSynchronizedPool);
+  PmrResource& resource = kind == MemoryResourceKind::kSynchronizedPool
+                              ? synchronized_pool
+                              : new_delete;
+  const int64_t n = state.range(1);
+  for (auto _ : state) {
+    PmrAges ages(resource.get());
+    Fill(ages, n);
+    benchmark::DoNotOptimize(ages.size());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  SetLabel(state, kind);
+}
+BENCHMARK(BM_SharedResource)
+    ->Args({static_cast<int64_t>(MemoryResourceKind::kNewDelete), 4096})
+    ->Args({static_cast<int64_t>(MemoryResourceKind::kSynchronizedPool), 4096})
+    ->ArgNames({"resource", "n"})
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
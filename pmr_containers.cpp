@@ -0,0 +1,50 @@
+#include "pmr_containers.h"
+
+#include <type_traits>
+
+const char* MemoryResourceName(MemoryResourceKind kind) {
+  switch (kind) {
+    case MemoryResourceKind::kNewDelete:
+      return "new_delete";
+    case MemoryResourceKind::kMonotonic:
+      return "monotonic";
+    case MemoryResourceKind::kUnsynchronizedPool:
+      return "unsynchronized_pool";
+    case MemoryResourceKind::kSynchronizedPool:
+      return "synchronized_pool";
+  }
+  return "";
+}
+
+PmrResource::PmrResource(MemoryResourceKind kind,
+                         std::pmr::memory_resource* upstream)
+    : kind_(kind) {
+  switch (kind) {
+    case MemoryResourceKind::kNewDelete:
+      resource_ = upstream;
+      break;
+    case MemoryResourceKind::kMonotonic:
+      resource_ =
+          &storage_.emplace<std::pmr::monotonic_buffer_resource>(upstream);
+      break;
+    case MemoryResourceKind::kUnsynchronizedPool:
+      resource_ =
+          &storage_.emplace<std::pmr::unsynchronized_pool_resource>(upstream);
+      break;
+    case MemoryResourceKind::kSynchronizedPool:
+      resource_ =
+          &storage_.emplace<std::pmr::synchronized_pool_resource>(upstream);
+      break;
+  }
+}
+
+void PmrResource::Release() {
+  std::visit(
+      [](auto& resource) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype(resource)>,
+                                      std::monostate>) {
+          resource.release();
+        }
+      },
+      storage_);
+}
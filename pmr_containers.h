@@ -0,0 +1,95 @@
+#ifndef PMR_CONTAINERS_H_
+#define PMR_CONTAINERS_H_
+
+// std::pmr ("polymorphic memory resource") versions of the containers in
+// main.cpp.
+//
+// A normal container bakes its allocator into its type, so switching
+// std::map<K, V> to an arena means changing the type everywhere it's passed
+// around (see ArenaAllocator in arena.h). A pmr container instead holds a
+// pointer to a std::pmr::memory_resource and asks it for memory at runtime.
+// Every call site uses the same type and picks where the memory comes from
+// when it constructs the container:
+//
+//   PmrResource resource(MemoryResourceKind::kMonotonic);
+//   PmrAges ages(resource.get());
+//   ages.insert({"Brian", 40});
+//
+// The resource has to outlive every container using it.
+//
+// The other nice thing about pmr is that it gets passed down automatically.
+// The std::pmr::string keys in PmrAges also allocate from the same resource,
+// which doesn't happen with a regular custom allocator.
+// https://en.cppreference.com/w/cpp/memory/memory_resource
+
+#include <map>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "person.h"
+
+// Arrays()
+using PmrNums = std::pmr::vector<int>;
+
+// Trees()
+using PmrIntSet = std::pmr::set<int>;
+using PmrAges = std::pmr::map<std::pmr::string, int>;
+
+// HashTables()
+using PmrUnorderedAges = std::pmr::unordered_map<std::pmr::string, int>;
+using PmrPeopleSet =
+    std::pmr::unordered_set<Person, PersonNameHash, PersonNameEq>;
+using PmrNames = std::pmr::set<std::pmr::string>;
+using PmrUnorderedNames = std::pmr::unordered_set<std::pmr::string>;
+
+enum class MemoryResourceKind {
+  // Plain new/delete, same as not using pmr at all.
+  kNewDelete,
+  // std::pmr::monotonic_buffer_resource. Bump allocation and deallocation
+  // does nothing, like Arena. Memory comes back with Release().
+  kMonotonic,
+  // std::pmr::unsynchronized_pool_resource. Keeps free lists for each size of
+  // allocation so freed memory gets reused. Single threaded only.
+  kUnsynchronizedPool,
+  // std::pmr::synchronized_pool_resource. Same, but safe to share between
+  // threads.
+  kSynchronizedPool,
+};
+
+const char* MemoryResourceName(MemoryResourceKind kind);
+
+// Owns one of the standard memory resources, chosen at runtime.
+class PmrResource {
+ public:
+  // Where the resource gets its big chunks of memory from. The default is
+  // plain new/delete.
+  explicit PmrResource(
+      MemoryResourceKind kind,
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+  PmrResource(const PmrResource&) = delete;
+  PmrResource& operator=(const PmrResource&) = delete;
+
+  std::pmr::memory_resource* get() { return resource_; }
+  MemoryResourceKind kind() const { return kind_; }
+
+  // Gives all memory back to the upstream resource, even memory that wasn't
+  // deallocated yet, so only call it once nothing is using the resource.
+  // Does nothing for kNewDelete.
+  void Release();
+
+ private:
+  MemoryResourceKind kind_;
+  std::variant<std::monostate, std::pmr::monotonic_buffer_resource,
+               std::pmr::unsynchronized_pool_resource,
+               std::pmr::synchronized_pool_resource>
+      storage_;
+  std::pmr::memory_resource* resource_;
+};
+
+#endif  // PMR_CONTAINERS_H_
@@ -0,0 +1,311 @@
+#ifndef RADIX_SORT_H_
+#define RADIX_SORT_H_
+
+// Sorting by a key without comparing elements to each other. Instead of a
+// comparator, RadixSort takes a function that gets the key out of an
+// element, and the key has to be an integer type or a string:
+//
+//   std::vector<Person> people = ...;
+//   RadixSort(people.begin(), people.end(),
+//             [](const Person& person) { return person.age; });
+//   StableRadixSort(people.begin(), people.end(),
+//                   [](const Person& person) -> const std::string& {
+//                     return person.name;
+//                   });
+//
+// Sorting by age gives the same order as Person::operator<. For strings,
+// return a reference or a std::string_view like above: a lambda that just
+// says `return person.name;` returns a copy of the string, and the sort
+// calls it over and over.
+//
+// Integer keys are sorted least significant digit (LSD) first. Each "digit"
+// is a byte of the key, and each pass moves every element into one of 256
+// buckets by that byte, keeping their order within a bucket. After the pass
+// for the top byte, everything is sorted. The counts for all the passes are
+// done in one go at the start, and a pass where every key has the same byte
+// is skipped. Ages from 0 to 99 only differ in their bottom byte, so sorting
+// people by age is one counting pass plus one pass moving them, no matter
+// how many there are, where std::sort does about log2(n) passes of
+// unpredictable comparisons. This needs a buffer as big as the input.
+//
+// String keys are sorted most significant digit (MSD) first, since strings
+// have different lengths and only the first few characters usually matter:
+// bucket by the first character, then sort each bucket by the second one,
+// and so on, switching to a comparison sort once a bucket gets small.
+//
+// Integer keys always keep elements with equal keys in their original order.
+// For string keys RadixSort doesn't, and moves elements between buckets by
+// swapping them in place (American flag sort, McIlroy et al. 1993), while
+// StableRadixSort does by moving them through a buffer as big as the input.
+//
+// The key function and the element type's moves must not throw.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace radix_sort_internal {
+
+// Below this many elements a comparison sort is faster than counting.
+constexpr ptrdiff_t kComparisonSortThreshold = 64;
+
+// One bucket for strings that end before the byte being looked at, plus one
+// per byte value.
+constexpr int kStringBuckets = 257;
+
+template <typename Iter, typename KeyFn>
+using KeyOf = std::decay_t<std::invoke_result_t<
+    KeyFn&, const typename std::iterator_traits<Iter>::value_type&>>;
+
+template <typename Key>
+constexpr bool kIsIntegerKey =
+    std::is_integral_v<Key> && !std::is_same_v<Key, bool>;
+template <typename Key>
+constexpr bool kIsStringKey = std::is_convertible_v<const Key&,
+                                                    std::string_view>;
+
+struct Identity {
+  template <typename T>
+  const T& operator()(const T& value) const {
+    return value;
+  }
+};
+
+// Maps an integer key to an unsigned one that sorts the same way. Flipping
+// the sign bit moves the negative numbers below the positive ones.
+template <typename Key>
+std::make_unsigned_t<Key> ToUnsigned(Key key) {
+  using Unsigned = std::make_unsigned_t<Key>;
+  if constexpr (std::is_signed_v<Key>) {
+    constexpr Unsigned kSignBit = Unsigned{1} << (sizeof(Key) * 8 - 1);
+    return static_cast<Unsigned>(static_cast<Unsigned>(key) ^ kSignBit);
+  } else {
+    return key;
+  }
+}
+
+template <typename Key>
+uint8_t ByteOf(Key key, int byte) {
+  return static_cast<uint8_t>(ToUnsigned(key) >> (8 * byte));
+}
+
+// 0 if the string ends before `depth`, otherwise 1 + the byte there.
+inline int BucketOf(std::string_view key, size_t depth) {
+  return depth < key.size() ? 1 + static_cast<uint8_t>(key[depth]) : 0;
+}
+
+inline std::string_view Suffix(std::string_view key, size_t depth) {
+  key.remove_prefix(depth);
+  return key;
+}
+
+// Moves [begin, end) to out, each element to offsets[its byte]++. With
+// kConstruct, out is raw memory and the elements get move constructed there.
+template <bool kConstruct, typename In, typename Out, typename KeyFn>
+void ScatterByByte(In begin, In end, Out out, int byte, size_t* offsets,
+                   KeyFn& key) {
+  using T = typename std::iterator_traits<In>::value_type;
+  for (In it = begin; it != end; ++it) {
+    const Out slot = out + offsets[ByteOf(key(*it), byte)]++;
+    if constexpr (kConstruct) {
+      ::new (static_cast<void*>(slot)) T(std::move(*it));
+    } else {
+      *slot = std::move(*it);
+    }
+  }
+}
+
+template <typename Iter, typename KeyFn>
+void LsdSort(Iter begin, Iter end, KeyFn& key) {
+  using T = typename std::iterator_traits<Iter>::value_type;
+  using Key = KeyOf<Iter, KeyFn>;
+  constexpr int kBytes = sizeof(Key);
+  if (end - begin < kComparisonSortThreshold) {
+    std::stable_sort(begin, end, [&key](const T& lhs, const T& rhs) {
+      return key(lhs) < key(rhs);
+    });
+    return;
+  }
+
+  const size_t n = end - begin;
+  std::array<std::array<size_t, 256>, kBytes> counts = {};
+  for (Iter it = begin; it != end; ++it) {
+    const Key k = key(*it);
+    for (int byte = 0; byte < kBytes; ++byte) ++counts[byte][ByteOf(k, byte)];
+  }
+
+  // The passes go back and forth between the input and the buffer. The
+  // buffer starts out as raw memory, and the first pass into it constructs
+  // the elements.
+  const Key first_key = key(*begin);
+  std::allocator<T> alloc;
+  T* buffer = alloc.allocate(n);
+  bool in_buffer = false;
+  bool constructed = false;
+  for (int byte = 0; byte < kBytes; ++byte) {
+    std::array<size_t, 256>& offsets = counts[byte];
+    // Every key has the same byte here, so the pass wouldn't change anything.
+    if (offsets[ByteOf(first_key, byte)] == n) continue;
+    size_t sum = 0;
+    for (size_t& offset : offsets) sum += std::exchange(offset, sum);
+    if (in_buffer) {
+      ScatterByByte<false>(buffer, buffer + n, begin, byte, offsets.data(),
+                           key);
+    } else if (constructed) {
+      ScatterByByte<false>(begin, end, buffer, byte, offsets.data(), key);
+    } else {
+      ScatterByByte<true>(begin, end, buffer, byte, offsets.data(), key);
+      constructed = true;
+    }
+    in_buffer = !in_buffer;
+  }
+  if (in_buffer) std::move(buffer, buffer + n, begin);
+  if (constructed) std::destroy_n(buffer, n);
+  alloc.deallocate(buffer, n);
+}
+
+// A range of elements whose keys all start with the same `depth` bytes.
+struct MsdRange {
+  ptrdiff_t begin;
+  ptrdiff_t end;
+  size_t depth;
+};
+
+// Moves each element of the range into its bucket by way of the buffer,
+// keeping their order within a bucket.
+template <typename Iter, typename T, typename KeyFn>
+void DistributeStable(Iter begin, const MsdRange& range,
+                      const ptrdiff_t* starts, T* buffer, KeyFn& key) {
+  std::array<ptrdiff_t, kStringBuckets> next;
+  std::copy_n(starts, kStringBuckets, next.begin());
+  for (Iter it = begin + range.begin; it != begin + range.end; ++it) {
+    const int b = BucketOf(key(*it), range.depth);
+    ::new (static_cast<void*>(buffer + next[b]++)) T(std::move(*it));
+  }
+  std::move(buffer + range.begin, buffer + range.end, begin + range.begin);
+  std::destroy(buffer + range.begin, buffer + range.end);
+}
+
+// Moves each element of the range into its bucket in place: takes the next
+// element that isn't in its bucket yet and swaps it into the next free place
+// of the bucket it belongs in, until every bucket is full.
+template <typename Iter, typename KeyFn>
+void DistributeInPlace(Iter begin, const MsdRange& range,
+                       const ptrdiff_t* starts, KeyFn& key) {
+  std::array<ptrdiff_t, kStringBuckets> next;
+  std::copy_n(starts, kStringBuckets, next.begin());
+  for (int b = 0; b < kStringBuckets; ++b) {
+    while (next[b] < starts[b + 1]) {
+      const int target = BucketOf(key(begin[next[b]]), range.depth);
+      if (target == b) {
+        ++next[b];
+      } else {
+        using std::swap;
+        swap(begin[next[b]], begin[next[target]++]);
+      }
+    }
+  }
+}
+
+// Both MSD sorts keep a stack of ranges still to sort rather than
+// recursing, since long shared prefixes would otherwise mean one stack frame
+// per shared byte.
+template <bool kStable, typename Iter, typename KeyFn>
+void MsdSort(Iter begin, Iter end, KeyFn& key) {
+  using T = typename std::iterator_traits<Iter>::value_type;
+  const ptrdiff_t n = end - begin;
+  std::allocator<T> alloc;
+  T* buffer = kStable && n >= kComparisonSortThreshold ? alloc.allocate(n)
+                                                       : nullptr;
+  std::vector<MsdRange> stack = {{0, n, 0}};
+  while (!stack.empty()) {
+    const MsdRange range = stack.back();
+    stack.pop_back();
+    const Iter first = begin + range.begin;
+    const Iter last = begin + range.end;
+    if (range.end - range.begin < kComparisonSortThreshold) {
+      // Everything here has the same first `depth` bytes, so only compare
+      // the rest.
+      auto less = [&key, depth = range.depth](const T& lhs, const T& rhs) {
+        return Suffix(key(lhs), depth) < Suffix(key(rhs), depth);
+      };
+      if constexpr (kStable) {
+        std::stable_sort(first, last, less);
+      } else {
+        std::sort(first, last, less);
+      }
+      continue;
+    }
+
+    std::array<ptrdiff_t, kStringBuckets> counts = {};
+    for (Iter it = first; it != last; ++it) {
+      ++counts[BucketOf(key(*it), range.depth)];
+    }
+    std::array<ptrdiff_t, kStringBuckets + 1> starts;
+    starts[0] = range.begin;
+    for (int b = 0; b < kStringBuckets; ++b) {
+      starts[b + 1] = starts[b] + counts[b];
+    }
+    // If they all have the same byte here there's nothing to move, which
+    // happens a lot with shared prefixes.
+    const int first_bucket = BucketOf(key(*first), range.depth);
+    if (counts[first_bucket] != range.end - range.begin) {
+      if constexpr (kStable) {
+        DistributeStable(begin, range, starts.data(), buffer, key);
+      } else {
+        DistributeInPlace(begin, range, starts.data(), key);
+      }
+    }
+
+    // Bucket 0 is the strings that ended, which are all equal.
+    for (int b = 1; b < kStringBuckets; ++b) {
+      if (starts[b + 1] - starts[b] > 1) {
+        stack.push_back({starts[b], starts[b + 1], range.depth + 1});
+      }
+    }
+  }
+  if (buffer != nullptr) alloc.deallocate(buffer, n);
+}
+
+template <bool kStable, typename Iter, typename KeyFn>
+void Sort(Iter begin, Iter end, KeyFn& key) {
+  using Key = KeyOf<Iter, KeyFn>;
+  static_assert(kIsIntegerKey<Key> || kIsStringKey<Key>,
+                "RadixSort keys have to be integers or convertible to "
+                "std::string_view");
+  if constexpr (kIsIntegerKey<Key>) {
+    LsdSort(begin, end, key);
+  } else {
+    MsdSort<kStable>(begin, end, key);
+  }
+}
+
+}  // namespace radix_sort_internal
+
+// Sorts [begin, end) by key(element), which has to return an integer type or
+// something convertible to std::string_view.
+template <typename Iter, typename KeyFn>
+void RadixSort(Iter begin, Iter end, KeyFn key) {
+  radix_sort_internal::Sort</*kStable=*/false>(begin, end, key);
+}
+// The same, keeping elements with equal keys in their original order.
+template <typename Iter, typename KeyFn>
+void StableRadixSort(Iter begin, Iter end, KeyFn key) {
+  radix_sort_internal::Sort</*kStable=*/true>(begin, end, key);
+}
+
+// For sorting ints or strings themselves.
+template <typename Iter>
+void RadixSort(Iter begin, Iter end) {
+  RadixSort(begin, end, radix_sort_internal::Identity());
+}
+
+#endif  // RADIX_SORT_H_
@@ -0,0 +1,99 @@
+// RadixSort against std::sort and std::stable_sort on vector<Person> and
+// vector<int>. Run with:
+//   bazel run -c opt :radix_sort_bench
+//
+// By age, the comparison sorts use Person::operator< and RadixSort takes
+// the age as its key. By name, the comparison sorts use PersonNameLess, the
+// named version of person_comp from main.cpp, and RadixSort takes a
+// reference to the name.
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "person.h"
+#include "radix_sort.h"
+
+namespace {
+
+int Age(const Person& person) { return person.age; }
+const std::string& Name(const Person& person) { return person.name; }
+
+std::vector<int> MakeInts(int64_t n) {
+  std::mt19937 rng(n);
+  std::vector<int> nums_vector(n);
+  for (int& x : nums_vector) x = static_cast<int>(rng());
+  return nums_vector;
+}
+
+void BM_IntsStdSort(benchmark::State& state) {
+  RunSort(state, MakeInts(state.range(0)), [](std::vector<int>& values) {
+    std::sort(values.begin(), values.end());
+  });
+}
+void BM_IntsRadixSort(benchmark::State& state) {
+  RunSort(state, MakeInts(state.range(0)), [](std::vector<int>& values) {
+    RadixSort(values.begin(), values.end());
+  });
+}
+
+void BM_AgeStdSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    std::sort(people.begin(), people.end());
+  });
+}
+void BM_AgeStdStableSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    std::stable_sort(people.begin(), people.end());
+  });
+}
+// Already stable for integer keys.
+void BM_AgeRadixSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    RadixSort(people.begin(), people.end(), Age);
+  });
+}
+
+void BM_NameStdSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    std::sort(people.begin(), people.end(), PersonNameLess());
+  });
+}
+void BM_NameStdStableSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    std::stable_sort(people.begin(), people.end(), PersonNameLess());
+  });
+}
+void BM_NameRadixSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    RadixSort(people.begin(), people.end(), Name);
+  });
+}
+void BM_NameStableRadixSort(benchmark::State& state) {
+  RunSort(state, MakePeople(state.range(0)), [](std::vector<Person>& people) {
+    StableRadixSort(people.begin(), people.end(), Name);
+  });
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {1 << 10, 1 << 16, 1 << 20, 8 << 20}) b->Arg(n);
+  b->UseRealTime()->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(BM_IntsStdSort)->Apply(Sizes);
+BENCHMARK(BM_IntsRadixSort)->Apply(Sizes);
+BENCHMARK(BM_AgeStdSort)->Apply(Sizes);
+BENCHMARK(BM_AgeStdStableSort)->Apply(Sizes);
+BENCHMARK(BM_AgeRadixSort)->Apply(Sizes);
+BENCHMARK(BM_NameStdSort)->Apply(Sizes);
+BENCHMARK(BM_NameStdStableSort)->Apply(Sizes);
+BENCHMARK(BM_NameRadixSort)->Apply(Sizes);
+BENCHMARK(BM_NameStableRadixSort)->Apply(Sizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();
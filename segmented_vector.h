@@ -0,0 +1,398 @@
+#ifndef SEGMENTED_VECTOR_H_
+#define SEGMENTED_VECTOR_H_
+
+// SegmentedVector<T> is a vector that never moves its elements.
+//
+// When std::vector runs out of room, push_back allocates a bigger array,
+// moves every element over and frees the old one. That's O(1) on average,
+// but the one push_back that does it takes as long as copying the whole
+// vector, which for a table of 100M Persons is a very noticeable stall. It
+// also invalidates every pointer and reference into the vector, so you can't
+// hold on to a Person* across a push_back.
+//
+// SegmentedVector grows by adding another segment instead and leaves the
+// existing ones where they are. Segment k holds FirstSegment * 2^k elements,
+// so like vector the total capacity doubles each time, but growing only costs
+// one allocation. Pointers and references stay valid until the element is
+// popped or the vector is cleared.
+//
+//   SegmentedVector<Person> people;
+//   Person* brian = &people.emplace_back(Person{"Brian", 39});
+//   for (int i = 0; i < 1'000'000; ++i) people.push_back(...);
+//   brian->age;  // Still fine.
+//
+// Indexing is still O(1): which segment element i is in is a leading zero
+// count on i / FirstSegment + 1, then an array lookup. It's a bit slower than
+// vector's single add, and elements aren't contiguous overall so there's no
+// data(). Iterators step through a segment with a plain pointer increment.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template <typename T, size_t FirstSegment = 16>
+class SegmentedVector {
+  static_assert(FirstSegment > 0 && (FirstSegment & (FirstSegment - 1)) == 0,
+                "FirstSegment has to be a power of two.");
+
+  template <bool kConst>
+  class Iterator;
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  SegmentedVector() noexcept = default;
+  explicit SegmentedVector(size_type count) { resize(count); }
+  SegmentedVector(std::initializer_list<T> init) {
+    reserve(init.size());
+    for (const T& value : init) push_back(value);
+  }
+  SegmentedVector(const SegmentedVector& other) {
+    reserve(other.size_);
+    for (const T& value : other) push_back(value);
+  }
+  SegmentedVector(SegmentedVector&& other) noexcept { swap(other); }
+  ~SegmentedVector() {
+    clear();
+    shrink_to_fit();
+  }
+
+  SegmentedVector& operator=(const SegmentedVector& other) {
+    if (this != &other) {
+      SegmentedVector copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+  SegmentedVector& operator=(SegmentedVector&& other) noexcept {
+    if (this != &other) {
+      SegmentedVector moved(std::move(other));
+      swap(moved);
+    }
+    return *this;
+  }
+
+  reference operator[](size_type pos) { return *Slot(pos); }
+  const_reference operator[](size_type pos) const { return *Slot(pos); }
+  reference at(size_type pos) {
+    if (pos >= size_) throw std::out_of_range("SegmentedVector::at");
+    return *Slot(pos);
+  }
+  const_reference at(size_type pos) const {
+    if (pos >= size_) throw std::out_of_range("SegmentedVector::at");
+    return *Slot(pos);
+  }
+  reference front() { return *Slot(0); }
+  const_reference front() const { return *Slot(0); }
+  reference back() { return *Slot(size_ - 1); }
+  const_reference back() const { return *Slot(size_ - 1); }
+
+  iterator begin() noexcept { return iterator(this, 0); }
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(this, size_); }
+  const_iterator end() const noexcept { return const_iterator(this, size_); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type capacity() const noexcept {
+    return SegmentOffset(num_segments_);
+  }
+
+  // Allocates segments until there's room for `new_capacity` elements.
+  void reserve(size_type new_capacity) {
+    while (capacity() < new_capacity) AddSegment();
+  }
+
+  // Frees segments past the one holding the last element.
+  void shrink_to_fit() noexcept {
+    size_t needed = size_ == 0 ? 0 : SegmentOf(size_ - 1) + 1;
+    while (num_segments_ > needed) {
+      --num_segments_;
+      ::operator delete(segments_[num_segments_],
+                        std::align_val_t(alignof(T)));
+      segments_[num_segments_] = nullptr;
+    }
+    FindEnd();
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    if (end_ == segment_end_) {
+      // The current segment is full.
+      if (size_ == capacity()) AddSegment();
+      FindEnd();
+    }
+    T* slot = ::new (static_cast<void*>(end_)) T(std::forward<Args>(args)...);
+    ++end_;
+    ++size_;
+    return *slot;
+  }
+
+  void pop_back() {
+    assert(size_ > 0 && "pop_back on empty SegmentedVector");
+    --size_;
+    FindEnd();
+    std::destroy_at(end_);
+  }
+
+  // Keeps the segments, like vector::clear keeps its capacity.
+  void clear() noexcept {
+    ForEachSegment([](T* data, size_t count) { std::destroy_n(data, count); });
+    size_ = 0;
+    FindEnd();
+  }
+
+  // Growing value-initializes the new elements, same as std::vector.
+  void resize(size_type count) {
+    while (size_ > count) pop_back();
+    reserve(count);
+    while (size_ < count) emplace_back();
+  }
+
+  void swap(SegmentedVector& other) noexcept {
+    std::swap(segments_, other.segments_);
+    std::swap(num_segments_, other.num_segments_);
+    std::swap(size_, other.size_);
+    std::swap(end_, other.end_);
+    std::swap(segment_end_, other.segment_end_);
+  }
+
+  // Calls fn(data, count) for each segment in order, where data[0..count) are
+  // that segment's elements. Faster than iterators for a scan.
+  template <typename Fn>
+  void ForEachSegment(Fn&& fn) {
+    size_t remaining = size_;
+    for (size_t k = 0; remaining > 0; ++k) {
+      size_t count = std::min(remaining, SegmentSize(k));
+      fn(segments_[k], count);
+      remaining -= count;
+    }
+  }
+  template <typename Fn>
+  void ForEachSegment(Fn&& fn) const {
+    const_cast<SegmentedVector*>(this)->ForEachSegment(
+        [&fn](T* data, size_t count) {
+          fn(static_cast<const T*>(data), count);
+        });
+  }
+
+ private:
+  // As many segments as fit before the sizes overflow size_t, which is more
+  // than any address space anyway.
+  static constexpr size_t kMaxSegments = 63 - __builtin_ctzll(FirstSegment);
+
+  static constexpr size_t SegmentSize(size_t k) { return FirstSegment << k; }
+
+  // Index of the first element in segment k. Segments 0..k-1 hold
+  // FirstSegment * (2^k - 1) elements between them.
+  static constexpr size_t SegmentOffset(size_t k) {
+    return FirstSegment * ((size_t{1} << k) - 1);
+  }
+
+  // Which segment element `pos` is in: the k where
+  // SegmentOffset(k) <= pos < SegmentOffset(k + 1), which works out to the
+  // highest set bit of pos / FirstSegment + 1.
+  static size_t SegmentOf(size_t pos) {
+    uint64_t n = pos / FirstSegment + 1;
+    return 63 - __builtin_clzll(n);
+  }
+
+  T* Slot(size_t pos) const {
+    size_t k = SegmentOf(pos);
+    return segments_[k] + (pos - SegmentOffset(k));
+  }
+
+  // Points end_ at where the next element goes and segment_end_ at the end of
+  // its segment, or both at nothing if every segment is full.
+  void FindEnd() noexcept {
+    if (size_ == capacity()) {
+      end_ = segment_end_ = nullptr;
+    } else {
+      size_t k = SegmentOf(size_);
+      end_ = segments_[k] + (size_ - SegmentOffset(k));
+      segment_end_ = segments_[k] + SegmentSize(k);
+    }
+  }
+
+  void AddSegment() {
+    if (num_segments_ == kMaxSegments) {
+      throw std::length_error("SegmentedVector too big");
+    }
+    segments_[num_segments_] = static_cast<T*>(
+        ::operator new(SegmentSize(num_segments_) * sizeof(T),
+                       std::align_val_t(alignof(T))));
+    ++num_segments_;
+  }
+
+  template <bool kConst>
+  class Iterator {
+    using Vector =
+        std::conditional_t<kConst, const SegmentedVector, SegmentedVector>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<kConst, const T*, T*>;
+    using reference = std::conditional_t<kConst, const T&, T&>;
+
+    Iterator() = default;
+    Iterator(Vector* vector, size_t index) : vector_(vector), index_(index) {
+      FindSegment();
+    }
+    // iterator converts to const_iterator, not the other way around.
+    template <bool kOtherConst,
+              typename = std::enable_if_t<kConst && !kOtherConst>>
+    Iterator(const Iterator<kOtherConst>& other)
+        : vector_(other.vector_),
+          index_(other.index_),
+          cur_(other.cur_),
+          segment_begin_(other.segment_begin_),
+          segment_end_(other.segment_end_) {}
+
+    reference operator*() const { return *cur_; }
+    pointer operator->() const { return cur_; }
+    reference operator[](difference_type n) const {
+      return *vector_->Slot(index_ + n);
+    }
+
+    Iterator& operator++() {
+      ++index_;
+      if (++cur_ == segment_end_) FindSegment();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+    Iterator& operator--() {
+      --index_;
+      if (cur_ == segment_begin_) {
+        FindSegment();
+      } else {
+        --cur_;
+      }
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --*this;
+      return old;
+    }
+    Iterator& operator+=(difference_type n) {
+      index_ += n;
+      FindSegment();
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index_ -= n;
+      FindSegment();
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator& a, const Iterator& b) {
+      return static_cast<difference_type>(a.index_) -
+             static_cast<difference_type>(b.index_);
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.index_ == b.index_;
+    }
+    friend bool operator!=(const Iterator& a, const Iterator& b) {
+      return a.index_ != b.index_;
+    }
+    friend bool operator<(const Iterator& a, const Iterator& b) {
+      return a.index_ < b.index_;
+    }
+    friend bool operator>(const Iterator& a, const Iterator& b) {
+      return a.index_ > b.index_;
+    }
+    friend bool operator<=(const Iterator& a, const Iterator& b) {
+      return a.index_ <= b.index_;
+    }
+    friend bool operator>=(const Iterator& a, const Iterator& b) {
+      return a.index_ >= b.index_;
+    }
+
+   private:
+    template <bool>
+    friend class Iterator;
+
+    // Points cur_ at element index_, or at nothing for end().
+    void FindSegment() {
+      if (index_ < vector_->size_) {
+        size_t k = SegmentOf(index_);
+        segment_begin_ = vector_->segments_[k];
+        segment_end_ = segment_begin_ + SegmentSize(k);
+        cur_ = segment_begin_ + (index_ - SegmentOffset(k));
+      } else {
+        cur_ = segment_begin_ = segment_end_ = nullptr;
+      }
+    }
+
+    Vector* vector_ = nullptr;
+    // Compared and subtracted by index, since end() has no element to point
+    // at.
+    size_t index_ = 0;
+    pointer cur_ = nullptr;
+    pointer segment_begin_ = nullptr;
+    pointer segment_end_ = nullptr;
+  };
+
+  // The table of segments is inside the object so it never moves either.
+  T* segments_[kMaxSegments] = {};
+  size_t num_segments_ = 0;
+  size_t size_ = 0;
+  // So push_back is a compare and a pointer increment, until it gets to the
+  // end of a segment.
+  T* end_ = nullptr;
+  T* segment_end_ = nullptr;
+};
+
+template <typename T, size_t FirstSegment>
+void swap(SegmentedVector<T, FirstSegment>& a,
+          SegmentedVector<T, FirstSegment>& b) noexcept {
+  a.swap(b);
+}
+
+#endif  // SEGMENTED_VECTOR_H_
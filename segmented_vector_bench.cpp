@@ -0,0 +1,137 @@
+// SegmentedVector against std::vector. Run with:
+//   bazel run -c opt :segmented_vector_bench
+//
+// The point of SegmentedVector is the tail latency of push_back, so
+// BM_PushBackLatency times every single push_back and reports percentiles.
+// std::vector's p50 is lower, but its max is the time to move the whole table
+// over, which grows with the table. SegmentedVector's max is one allocation.
+// The other benchmarks show what that costs on reads.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "person.h"
+#include "segmented_vector.h"
+
+namespace {
+
+template <typename V>
+void BM_PushBackLatency(benchmark::State& state) {
+  using T = typename V::value_type;
+  const int64_t n = state.range(0);
+  std::vector<int64_t> nanos(n);
+  for (auto _ : state) {
+    V table;
+    for (int64_t i = 0; i < n; ++i) {
+      T value = MakeKey<T>(i);
+      auto start = std::chrono::steady_clock::now();
+      table.push_back(std::move(value));
+      nanos[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    }
+    benchmark::DoNotOptimize(table.back());
+    state.PauseTiming();
+    table = V();
+    state.ResumeTiming();
+  }
+  // Percentiles from the last iteration.
+  std::sort(nanos.begin(), nanos.end());
+  auto percentile = [&](double p) { return nanos[(n - 1) * p]; };
+  state.counters["p50_ns"] = percentile(0.5);
+  state.counters["p99_ns"] = percentile(0.99);
+  state.counters["p999_ns"] = percentile(0.999);
+  state.counters["max_ns"] = nanos.back();
+}
+BENCHMARK_TEMPLATE(BM_PushBackLatency, std::vector<Person>)
+    ->RangeMultiplier(10)
+    ->Range(100'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBackLatency, SegmentedVector<Person>)
+    ->RangeMultiplier(10)
+    ->Range(100'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+// nums_vector.push_back in a loop, without timing each one.
+template <typename V>
+void BM_PushBack(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  for (auto _ : state) {
+    V nums_vector;
+    for (int64_t i = 0; i < n; ++i) nums_vector.push_back(i);
+    benchmark::DoNotOptimize(nums_vector.back());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_PushBack, std::vector<int>)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 100'000'000);
+BENCHMARK_TEMPLATE(BM_PushBack, SegmentedVector<int>)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 100'000'000);
+
+// Reads at random indexes. This is where the segment lookup shows up.
+template <typename V>
+void BM_RandomIndex(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  V nums_vector;
+  for (int64_t i = 0; i < n; ++i) nums_vector.push_back(i);
+  ScrambledOrder order(n);
+  int64_t i = 0;
+  int64_t sum = 0;
+  for (auto _ : state) {
+    sum += nums_vector[order[i]];
+    if (++i == n) i = 0;
+  }
+  benchmark::DoNotOptimize(sum);
+}
+BENCHMARK_TEMPLATE(BM_RandomIndex, std::vector<int>)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 10'000'000);
+BENCHMARK_TEMPLATE(BM_RandomIndex, SegmentedVector<int>)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 10'000'000);
+
+// Sums every element with a range-for.
+template <typename V>
+void BM_Scan(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  V nums_vector;
+  for (int64_t i = 0; i < n; ++i) nums_vector.push_back(i);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (int x : nums_vector) sum += x;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_Scan, std::vector<int>)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 10'000'000);
+BENCHMARK_TEMPLATE(BM_Scan, SegmentedVector<int>)
+    ->RangeMultiplier(100)
+    ->Range(1'000, 10'000'000);
+
+// Same, a segment at a time.
+void BM_ScanSegments(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  SegmentedVector<int> nums_vector;
+  for (int64_t i = 0; i < n; ++i) nums_vector.push_back(i);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    nums_vector.ForEachSegment([&](const int* data, size_t count) {
+      for (size_t j = 0; j < count; ++j) sum += data[j];
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ScanSegments)->RangeMultiplier(100)->Range(1'000, 10'000'000);
+
+}  // namespace
+
+BENCHMARK_MAIN();
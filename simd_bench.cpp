@@ -0,0 +1,104 @@
+// Every kernel in simd_kernels.h at every SIMD level this CPU supports, in
+// GB/s of input. Run with:
+//   bazel run -c opt :simd_bench
+//
+// Sizes go from 16 KB, which fits in L1, to 256 MB, which doesn't fit in any
+// cache. Expect the levels to spread out at the small sizes and bunch up at
+// the big ones, where it's all memory bandwidth.
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "simd_kernels.h"
+
+namespace {
+
+using simd::SimdLevel;
+
+// nums_vector with n values from a small range, so CountEqual, FindFirst and
+// FilterGreaterThan have something to find.
+std::vector<int> MakeNums(int64_t n) {
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<int> value(0, 999);
+  std::vector<int> nums_vector(n);
+  for (int& x : nums_vector) x = value(rng);
+  return nums_vector;
+}
+
+// Runs `kernel` over nums_vector at `level` and reports input bytes per
+// second.
+template <typename Kernel>
+void RunKernel(benchmark::State& state, SimdLevel level, Kernel kernel) {
+  const int64_t n = state.range(0);
+  std::vector<int> nums_vector = MakeNums(n);
+  std::vector<int> out(n);
+  simd::SetSimdLevel(level);
+  for (auto _ : state) {
+    kernel(nums_vector, out);
+    benchmark::ClobberMemory();
+  }
+  simd::SetSimdLevel(simd::DetectedSimdLevel());
+  state.SetBytesProcessed(state.iterations() * n * sizeof(int));
+}
+
+void RegisterAll() {
+  struct Kernel {
+    const char* name;
+    void (*run)(const std::vector<int>& in, std::vector<int>& out);
+  };
+  static const Kernel kKernels[] = {
+      {"Sum",
+       [](const std::vector<int>& in, std::vector<int>&) {
+         benchmark::DoNotOptimize(simd::Sum(in));
+       }},
+      {"MinMax",
+       [](const std::vector<int>& in, std::vector<int>&) {
+         benchmark::DoNotOptimize(simd::MinMax(in));
+       }},
+      {"CountEqual",
+       [](const std::vector<int>& in, std::vector<int>&) {
+         benchmark::DoNotOptimize(simd::CountEqual(in, 500));
+       }},
+      // Looks for a value that isn't there, so it has to scan everything.
+      {"FindFirst",
+       [](const std::vector<int>& in, std::vector<int>&) {
+         benchmark::DoNotOptimize(simd::FindFirst(in, -1));
+       }},
+      {"PrefixSum",
+       [](const std::vector<int>& in, std::vector<int>& out) {
+         simd::PrefixSum(in, absl::MakeSpan(out));
+       }},
+      // Keeps about half, which is the worst case for branchy scalar code.
+      {"FilterGreaterThan",
+       [](const std::vector<int>& in, std::vector<int>& out) {
+         benchmark::DoNotOptimize(
+             simd::FilterGreaterThan(in, 499, absl::MakeSpan(out)));
+       }},
+  };
+  for (const Kernel& kernel : kKernels) {
+    for (int l = 0; l <= static_cast<int>(simd::DetectedSimdLevel()); ++l) {
+      SimdLevel level = static_cast<SimdLevel>(l);
+      std::string name = std::string("BM_") + kernel.name + "/" +
+                         simd::SimdLevelName(level);
+      benchmark::RegisterBenchmark(name.c_str(),
+                                   RunKernel<decltype(kernel.run)>, level,
+                                   kernel.run)
+          ->RangeMultiplier(16)
+          ->Range(4 << 10, 64 << 20);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  RegisterAll();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
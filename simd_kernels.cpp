@@ -0,0 +1,591 @@
+#include "simd_kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+
+// The SIMD versions use GCC/Clang's target attribute, which compiles just
+// that function for a newer instruction set than the rest of the file. That's
+// what lets one binary carry all the versions.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#define TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+#endif
+
+namespace simd {
+namespace {
+
+// One version of every kernel, all for the same SIMD level. The public
+// functions call through whichever of these is active.
+struct Kernels {
+  int64_t (*sum)(const int* values, size_t n);
+  MinMaxResult (*min_max)(const int* values, size_t n);
+  int64_t (*count_equal)(const int* values, size_t n, int value);
+  int64_t (*find_first)(const int* values, size_t n, int value);
+  void (*prefix_sum)(const int* in, size_t n, int* out);
+  size_t (*filter_greater_than)(const int* in, size_t n, int threshold,
+                                int* out);
+};
+
+// Scalar versions. These are also used for the leftover elements at the end
+// of the SIMD loops.
+
+int64_t SumScalar(const int* values, size_t n) {
+  int64_t sum = 0;
+  for (size_t i = 0; i < n; ++i) sum += values[i];
+  return sum;
+}
+
+MinMaxResult MinMaxScalar(const int* values, size_t n) {
+  MinMaxResult result{INT_MAX, INT_MIN};
+  for (size_t i = 0; i < n; ++i) {
+    result.min = std::min(result.min, values[i]);
+    result.max = std::max(result.max, values[i]);
+  }
+  return result;
+}
+
+int64_t CountEqualScalar(const int* values, size_t n, int value) {
+  int64_t count = 0;
+  for (size_t i = 0; i < n; ++i) count += values[i] == value;
+  return count;
+}
+
+int64_t FindFirstScalar(const int* values, size_t n, int value) {
+  for (size_t i = 0; i < n; ++i) {
+    if (values[i] == value) return i;
+  }
+  return -1;
+}
+
+// Adds `carry` (the sum so far) to the running total. Done in uint32_t so
+// overflow wraps instead of being undefined behavior.
+void PrefixSumScalar(const int* in, size_t n, int* out, uint32_t carry = 0) {
+  for (size_t i = 0; i < n; ++i) {
+    carry += static_cast<uint32_t>(in[i]);
+    out[i] = static_cast<int>(carry);
+  }
+}
+
+size_t FilterGreaterThanScalar(const int* in, size_t n, int threshold,
+                               int* out) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (in[i] > threshold) out[count++] = in[i];
+  }
+  return count;
+}
+
+constexpr Kernels kScalarKernels = {
+    SumScalar,       MinMaxScalar,           CountEqualScalar,
+    FindFirstScalar, [](const int* in, size_t n, int* out) {
+      PrefixSumScalar(in, n, out);
+    },
+    FilterGreaterThanScalar,
+};
+
+#if SIMD_KERNELS_X86
+
+// The count kernels count matches in 32-bit lanes, which would overflow after
+// 2^32 vectors. Splitting the input into blocks this big keeps them safe.
+constexpr size_t kCountBlock = size_t{1} << 30;
+
+// Filtering works by comparing a vector of values against the threshold,
+// which gives a bit mask of which ones match, then shuffling the matching
+// ones to the front with a lookup table indexed by the mask. These build the
+// tables: entry m lists the lanes whose bit is set in m, in order.
+struct SseShuffleTable {
+  alignas(16) uint8_t bytes[16][16];
+};
+constexpr SseShuffleTable MakeSseShuffleTable() {
+  SseShuffleTable table = {};
+  for (int mask = 0; mask < 16; ++mask) {
+    int out = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+      if ((mask >> lane) & 1) {
+        for (int byte = 0; byte < 4; ++byte) {
+          table.bytes[mask][out * 4 + byte] = lane * 4 + byte;
+        }
+        ++out;
+      }
+    }
+    // _mm_shuffle_epi8 zeroes bytes whose index has the top bit set.
+    for (; out < 4; ++out) {
+      for (int byte = 0; byte < 4; ++byte) {
+        table.bytes[mask][out * 4 + byte] = 0x80;
+      }
+    }
+  }
+  return table;
+}
+constexpr SseShuffleTable kSseShuffles = MakeSseShuffleTable();
+
+struct Avx2PermuteTable {
+  alignas(8) uint8_t lanes[256][8];
+};
+constexpr Avx2PermuteTable MakeAvx2PermuteTable() {
+  Avx2PermuteTable table = {};
+  for (int mask = 0; mask < 256; ++mask) {
+    int out = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+      if ((mask >> lane) & 1) table.lanes[mask][out++] = lane;
+    }
+  }
+  return table;
+}
+constexpr Avx2PermuteTable kAvx2Permutes = MakeAvx2PermuteTable();
+
+// SSE4.2: 4 ints at a time.
+
+TARGET_SSE42 int64_t SumSse42(const int* values, size_t n) {
+  // Widen to 64 bits before adding so the sum can't overflow.
+  __m128i sum0 = _mm_setzero_si128();
+  __m128i sum1 = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    sum0 = _mm_add_epi64(sum0, _mm_cvtepi32_epi64(x));
+    sum1 = _mm_add_epi64(sum1, _mm_cvtepi32_epi64(_mm_srli_si128(x, 8)));
+  }
+  __m128i sum = _mm_add_epi64(sum0, sum1);
+  return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1) +
+         SumScalar(values + i, n - i);
+}
+
+TARGET_SSE42 MinMaxResult MinMaxSse42(const int* values, size_t n) {
+  __m128i min = _mm_set1_epi32(INT_MAX);
+  __m128i max = _mm_set1_epi32(INT_MIN);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    min = _mm_min_epi32(min, x);
+    max = _mm_max_epi32(max, x);
+  }
+  // Reduce the 4 lanes to 1 by folding them in half twice.
+  min = _mm_min_epi32(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(1, 0, 3, 2)));
+  min = _mm_min_epi32(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(2, 3, 0, 1)));
+  max = _mm_max_epi32(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(1, 0, 3, 2)));
+  max = _mm_max_epi32(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(2, 3, 0, 1)));
+  MinMaxResult tail = MinMaxScalar(values + i, n - i);
+  return {std::min(_mm_cvtsi128_si32(min), tail.min),
+          std::max(_mm_cvtsi128_si32(max), tail.max)};
+}
+
+TARGET_SSE42 int64_t CountEqualSse42(const int* values, size_t n, int value) {
+  const __m128i needle = _mm_set1_epi32(value);
+  int64_t count = 0;
+  size_t i = 0;
+  while (i + 4 <= n) {
+    // Matching lanes compare to -1, so subtracting counts them.
+    __m128i counts = _mm_setzero_si128();
+    const size_t block_end = i + std::min(n - i, kCountBlock);
+    for (; i + 4 <= block_end; i += 4) {
+      __m128i x =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+      counts = _mm_sub_epi32(counts, _mm_cmpeq_epi32(x, needle));
+    }
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), counts);
+    count += int64_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+  }
+  return count + CountEqualScalar(values + i, n - i, value);
+}
+
+TARGET_SSE42 int64_t FindFirstSse42(const int* values, size_t n, int value) {
+  const __m128i needle = _mm_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, needle)));
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  int64_t tail = FindFirstScalar(values + i, n - i, value);
+  return tail < 0 ? -1 : i + tail;
+}
+
+TARGET_SSE42 void PrefixSumSse42(const int* in, size_t n, int* out) {
+  // Within a vector: add the vector shifted over by one lane, then by two,
+  // which leaves each lane holding the sum of itself and the lanes before it.
+  // Then add the running total from previous vectors.
+  __m128i carry = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi32(x, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+    carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  PrefixSumScalar(in + i, n - i, out + i,
+                  static_cast<uint32_t>(_mm_cvtsi128_si32(carry)));
+}
+
+TARGET_SSE42 size_t FilterGreaterThanSse42(const int* in, size_t n,
+                                           int threshold, int* out) {
+  const __m128i limit = _mm_set1_epi32(threshold);
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, limit)));
+    __m128i shuffle = _mm_load_si128(
+        reinterpret_cast<const __m128i*>(kSseShuffles.bytes[mask]));
+    // Always stores 4 lanes. count <= i, so that never goes past i + 3 in
+    // out, which is why out has to be as big as in.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count),
+                     _mm_shuffle_epi8(x, shuffle));
+    count += __builtin_popcount(mask);
+  }
+  return count +
+         FilterGreaterThanScalar(in + i, n - i, threshold, out + count);
+}
+
+constexpr Kernels kSse42Kernels = {
+    SumSse42,       MinMaxSse42,    CountEqualSse42,
+    FindFirstSse42, PrefixSumSse42, FilterGreaterThanSse42,
+};
+
+// AVX2: 8 ints at a time.
+
+TARGET_AVX2 int64_t SumAvx2(const int* values, size_t n) {
+  __m256i sum0 = _mm256_setzero_si256();
+  __m256i sum1 = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+    sum0 = _mm256_add_epi64(sum0,
+                            _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+    sum1 = _mm256_add_epi64(
+        sum1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+  }
+  __m256i sum4 = _mm256_add_epi64(sum0, sum1);
+  __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sum4),
+                              _mm256_extracti128_si256(sum4, 1));
+  return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1) +
+         SumScalar(values + i, n - i);
+}
+
+TARGET_AVX2 MinMaxResult MinMaxAvx2(const int* values, size_t n) {
+  __m256i min8 = _mm256_set1_epi32(INT_MAX);
+  __m256i max8 = _mm256_set1_epi32(INT_MIN);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+    min8 = _mm256_min_epi32(min8, x);
+    max8 = _mm256_max_epi32(max8, x);
+  }
+  __m128i min = _mm_min_epi32(_mm256_castsi256_si128(min8),
+                              _mm256_extracti128_si256(min8, 1));
+  __m128i max = _mm_max_epi32(_mm256_castsi256_si128(max8),
+                              _mm256_extracti128_si256(max8, 1));
+  min = _mm_min_epi32(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(1, 0, 3, 2)));
+  min = _mm_min_epi32(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(2, 3, 0, 1)));
+  max = _mm_max_epi32(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(1, 0, 3, 2)));
+  max = _mm_max_epi32(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(2, 3, 0, 1)));
+  MinMaxResult tail = MinMaxScalar(values + i, n - i);
+  return {std::min(_mm_cvtsi128_si32(min), tail.min),
+          std::max(_mm_cvtsi128_si32(max), tail.max)};
+}
+
+TARGET_AVX2 int64_t CountEqualAvx2(const int* values, size_t n, int value) {
+  const __m256i needle = _mm256_set1_epi32(value);
+  int64_t count = 0;
+  size_t i = 0;
+  while (i + 8 <= n) {
+    __m256i counts = _mm256_setzero_si256();
+    const size_t block_end = i + std::min(n - i, kCountBlock);
+    for (; i + 8 <= block_end; i += 8) {
+      __m256i x =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+      counts = _mm256_sub_epi32(counts, _mm256_cmpeq_epi32(x, needle));
+    }
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), counts);
+    for (uint32_t lane : lanes) count += lane;
+  }
+  return count + CountEqualScalar(values + i, n - i, value);
+}
+
+TARGET_AVX2 int64_t FindFirstAvx2(const int* values, size_t n, int value) {
+  const __m256i needle = _mm256_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+    int mask =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, needle)));
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  int64_t tail = FindFirstScalar(values + i, n - i, value);
+  return tail < 0 ? -1 : i + tail;
+}
+
+TARGET_AVX2 void PrefixSumAvx2(const int* in, size_t n, int* out) {
+  __m256i carry = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    // AVX2 shifts only work within each 128-bit half, so this gives a prefix
+    // sum of each half separately...
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    // ...then the low half's total gets added to the high half.
+    __m256i low_total = _mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    low_total = _mm256_permute2x128_si256(low_total, low_total, 0x08);
+    x = _mm256_add_epi32(x, low_total);
+    x = _mm256_add_epi32(x, carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+    carry = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+  }
+  PrefixSumScalar(in + i, n - i, out + i,
+                  static_cast<uint32_t>(_mm256_cvtsi256_si32(carry)));
+}
+
+TARGET_AVX2 size_t FilterGreaterThanAvx2(const int* in, size_t n,
+                                         int threshold, int* out) {
+  const __m256i limit = _mm256_set1_epi32(threshold);
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    int mask =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, limit)));
+    __m256i permute = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>(kAvx2Permutes.lanes[mask])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count),
+                        _mm256_permutevar8x32_epi32(x, permute));
+    count += __builtin_popcount(mask);
+  }
+  return count +
+         FilterGreaterThanScalar(in + i, n - i, threshold, out + count);
+}
+
+constexpr Kernels kAvx2Kernels = {
+    SumAvx2,       MinMaxAvx2,    CountEqualAvx2,
+    FindFirstAvx2, PrefixSumAvx2, FilterGreaterThanAvx2,
+};
+
+// GCC 12's AVX-512 headers trip its own uninitialized variable warnings
+// (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593).
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+// AVX-512: 16 ints at a time. Comparisons give a 16-bit mask directly, and
+// there are built in horizontal reductions and a compress instruction for
+// filtering, so these are simpler than the AVX2 ones.
+
+TARGET_AVX512 int64_t SumAvx512(const int* values, size_t n) {
+  __m512i sum0 = _mm512_setzero_si512();
+  __m512i sum1 = _mm512_setzero_si512();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(values + i);
+    sum0 = _mm512_add_epi64(sum0,
+                            _mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)));
+    sum1 = _mm512_add_epi64(
+        sum1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1)));
+  }
+  return _mm512_reduce_add_epi64(_mm512_add_epi64(sum0, sum1)) +
+         SumScalar(values + i, n - i);
+}
+
+TARGET_AVX512 MinMaxResult MinMaxAvx512(const int* values, size_t n) {
+  __m512i min = _mm512_set1_epi32(INT_MAX);
+  __m512i max = _mm512_set1_epi32(INT_MIN);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(values + i);
+    min = _mm512_min_epi32(min, x);
+    max = _mm512_max_epi32(max, x);
+  }
+  MinMaxResult tail = MinMaxScalar(values + i, n - i);
+  return {std::min(_mm512_reduce_min_epi32(min), tail.min),
+          std::max(_mm512_reduce_max_epi32(max), tail.max)};
+}
+
+TARGET_AVX512 int64_t CountEqualAvx512(const int* values, size_t n,
+                                       int value) {
+  const __m512i needle = _mm512_set1_epi32(value);
+  int64_t count = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(values + i);
+    count += __builtin_popcount(_mm512_cmpeq_epi32_mask(x, needle));
+  }
+  return count + CountEqualScalar(values + i, n - i, value);
+}
+
+TARGET_AVX512 int64_t FindFirstAvx512(const int* values, size_t n,
+                                      int value) {
+  const __m512i needle = _mm512_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(values + i);
+    __mmask16 mask = _mm512_cmpeq_epi32_mask(x, needle);
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  int64_t tail = FindFirstScalar(values + i, n - i, value);
+  return tail < 0 ? -1 : i + tail;
+}
+
+TARGET_AVX512 void PrefixSumAvx512(const int* in, size_t n, int* out) {
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i last_lane = _mm512_set1_epi32(15);
+  __m512i carry = zero;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(in + i);
+    // alignr(x, zero, 16 - k) shifts x up by k lanes across the whole
+    // register, filling in zeros.
+    x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 15));
+    x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 14));
+    x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 12));
+    x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 8));
+    x = _mm512_add_epi32(x, carry);
+    _mm512_storeu_si512(out + i, x);
+    carry = _mm512_permutexvar_epi32(last_lane, x);
+  }
+  PrefixSumScalar(in + i, n - i, out + i,
+                  static_cast<uint32_t>(
+                      _mm_cvtsi128_si32(_mm512_castsi512_si128(carry))));
+}
+
+TARGET_AVX512 size_t FilterGreaterThanAvx512(const int* in, size_t n,
+                                             int threshold, int* out) {
+  const __m512i limit = _mm512_set1_epi32(threshold);
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(in + i);
+    __mmask16 mask = _mm512_cmpgt_epi32_mask(x, limit);
+    // compress + a full store instead of compressstoreu, which is very slow
+    // on AMD chips.
+    _mm512_storeu_si512(out + count, _mm512_maskz_compress_epi32(mask, x));
+    count += __builtin_popcount(mask);
+  }
+  return count +
+         FilterGreaterThanScalar(in + i, n - i, threshold, out + count);
+}
+
+constexpr Kernels kAvx512Kernels = {
+    SumAvx512,       MinMaxAvx512,    CountEqualAvx512,
+    FindFirstAvx512, PrefixSumAvx512, FilterGreaterThanAvx512,
+};
+
+#pragma GCC diagnostic pop
+
+#endif  // SIMD_KERNELS_X86
+
+const Kernels* KernelsFor(SimdLevel level) {
+  switch (level) {
+#if SIMD_KERNELS_X86
+    case SimdLevel::kAvx512:
+      return &kAvx512Kernels;
+    case SimdLevel::kAvx2:
+      return &kAvx2Kernels;
+    case SimdLevel::kSse42:
+      return &kSse42Kernels;
+#endif
+    default:
+      return &kScalarKernels;
+  }
+}
+
+SimdLevel Detect() {
+#if SIMD_KERNELS_X86
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("popcnt")) return SimdLevel::kScalar;
+  if (__builtin_cpu_supports("avx512f")) return SimdLevel::kAvx512;
+  if (__builtin_cpu_supports("avx2")) return SimdLevel::kAvx2;
+  if (__builtin_cpu_supports("sse4.2")) return SimdLevel::kSse42;
+#endif
+  return SimdLevel::kScalar;
+}
+
+struct Active {
+  std::atomic<SimdLevel> level;
+  std::atomic<const Kernels*> kernels;
+};
+Active& GetActive() {
+  static Active* active = [] {
+    SimdLevel level = DetectedSimdLevel();
+    return new Active{{level}, {KernelsFor(level)}};
+  }();
+  return *active;
+}
+
+const Kernels& Get() {
+  return *GetActive().kernels.load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+const char* SimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kScalar:
+      return "scalar";
+    case SimdLevel::kSse42:
+      return "sse4.2";
+    case SimdLevel::kAvx2:
+      return "avx2";
+    case SimdLevel::kAvx512:
+      return "avx512";
+  }
+  return "";
+}
+
+SimdLevel DetectedSimdLevel() {
+  static const SimdLevel detected = Detect();
+  return detected;
+}
+
+SimdLevel ActiveSimdLevel() {
+  return GetActive().level.load(std::memory_order_relaxed);
+}
+
+SimdLevel SetSimdLevel(SimdLevel level) {
+  level = std::min(level, DetectedSimdLevel());
+  GetActive().level.store(level, std::memory_order_relaxed);
+  GetActive().kernels.store(KernelsFor(level), std::memory_order_relaxed);
+  return level;
+}
+
+int64_t Sum(absl::Span<const int> values) {
+  return Get().sum(values.data(), values.size());
+}
+
+MinMaxResult MinMax(absl::Span<const int> values) {
+  return Get().min_max(values.data(), values.size());
+}
+
+int64_t CountEqual(absl::Span<const int> values, int value) {
+  return Get().count_equal(values.data(), values.size(), value);
+}
+
+int64_t FindFirst(absl::Span<const int> values, int value) {
+  return Get().find_first(values.data(), values.size(), value);
+}
+
+void PrefixSum(absl::Span<const int> in, absl::Span<int> out) {
+  assert(out.size() >= in.size());
+  Get().prefix_sum(in.data(), in.size(), out.data());
+}
+
+size_t FilterGreaterThan(absl::Span<const int> in, int threshold,
+                         absl::Span<int> out) {
+  assert(out.size() >= in.size());
+  return Get().filter_greater_than(in.data(), in.size(), threshold,
+                                   out.data());
+}
+
+}  // namespace simd
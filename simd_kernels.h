@@ -0,0 +1,75 @@
+#ifndef SIMD_KERNELS_H_
+#define SIMD_KERNELS_H_
+
+// Fast scans over arrays of ints, like nums_vector from Arrays() or the
+// std::array from NotArrays(). Anything that converts to absl::Span<const
+// int> works, which includes both of those:
+//
+//   std::vector<int> nums_vector = ...;
+//   int64_t total = simd::Sum(nums_vector);
+//   int64_t where = simd::FindFirst(nums_vector, 777);
+//
+// Each kernel has a version for each x86 SIMD level: SSE4.2 works on 4 ints
+// at a time, AVX2 on 8 and AVX-512 on 16. Which one runs is picked at
+// startup from what the CPU says it supports (the CPUID instruction), so the
+// same binary uses AVX-512 on a machine that has it and still runs on one
+// that doesn't. Everything also has a plain scalar version, which is all you
+// get on non-x86 machines.
+//
+// The SIMD versions only win for arrays that are already in cache or being
+// streamed through it. Once the array is much bigger than the caches they're
+// all limited by memory bandwidth and mostly look the same.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+
+namespace simd {
+
+enum class SimdLevel { kScalar, kSse42, kAvx2, kAvx512 };
+
+const char* SimdLevelName(SimdLevel level);
+
+// The best level this CPU supports.
+SimdLevel DetectedSimdLevel();
+// The level the kernels are currently using. Starts as DetectedSimdLevel().
+SimdLevel ActiveSimdLevel();
+// Makes the kernels use `level` instead, e.g. to benchmark the levels against
+// each other or to rule the SIMD code out while debugging. Asking for more
+// than the CPU supports gets DetectedSimdLevel(). Returns the level actually
+// used. Don't call this while other threads are running kernels.
+SimdLevel SetSimdLevel(SimdLevel level);
+
+// Sum of all the values. Adds into 64 bits so it can't overflow.
+int64_t Sum(absl::Span<const int> values);
+
+struct MinMaxResult {
+  int min;
+  int max;
+};
+// Smallest and biggest value. For an empty span min is INT_MAX and max is
+// INT_MIN.
+MinMaxResult MinMax(absl::Span<const int> values);
+
+// How many values are equal to `value`.
+int64_t CountEqual(absl::Span<const int> values, int value);
+
+// Index of the first element equal to `value`, or -1.
+int64_t FindFirst(absl::Span<const int> values, int value);
+
+// out[i] = in[0] + ... + in[i]. Additions wrap around on overflow like
+// unsigned ints instead of being undefined. out has to be at least as big as
+// in, and can be the same array to do it in place.
+void PrefixSum(absl::Span<const int> in, absl::Span<int> out);
+
+// Copies the values greater than `threshold` to the front of out, keeping
+// their order, and returns how many there were. out has to be at least as big
+// as in, since everything might match. Elements past the returned count may
+// be overwritten with junk.
+size_t FilterGreaterThan(absl::Span<const int> in, int threshold,
+                         absl::Span<int> out);
+
+}  // namespace simd
+
+#endif  // SIMD_KERNELS_H_
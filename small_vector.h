@@ -0,0 +1,405 @@
+#ifndef SMALL_VECTOR_H_
+#define SMALL_VECTOR_H_
+
+// SmallVector<T, N> works just like std::vector<T>, except the first N
+// elements live inside the SmallVector object itself instead of on the heap.
+// It only allocates once you push more than N elements, at which point it
+// behaves like a regular vector.
+//
+// This is a win when you make lots of short-lived vectors that are almost
+// always small, because a heap allocation costs way more than filling in a few
+// ints. The downside is that the object is bigger (sizeof includes room for N
+// elements), and moving one that's still inline has to move every element
+// instead of just swapping a pointer. Same idea as absl::InlinedVector and
+// llvm::SmallVector.
+//
+//   SmallVector<int, 8> nums = {1, 2, 3};
+//   nums.push_back(4);  // No heap allocation until the 9th element.
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template <typename T, size_t N>
+class SmallVector {
+  static_assert(N > 0, "Use std::vector if you don't want inline storage.");
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  SmallVector() noexcept : data_(InlineData()), size_(0), capacity_(N) {}
+  explicit SmallVector(size_type count) : SmallVector() { resize(count); }
+  SmallVector(size_type count, const T& value) : SmallVector() {
+    assign(count, value);
+  }
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  SmallVector(InputIt first, InputIt last) : SmallVector() {
+    assign(first, last);
+  }
+  SmallVector(std::initializer_list<T> init) : SmallVector() { assign(init); }
+
+  SmallVector(const SmallVector& other) : SmallVector() {
+    assign(other.begin(), other.end());
+  }
+  SmallVector(SmallVector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>)
+      : SmallVector() {
+    TakeFrom(std::move(other));
+  }
+
+  ~SmallVector() {
+    std::destroy(begin(), end());
+    FreeHeap();
+  }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) assign(other.begin(), other.end());
+    return *this;
+  }
+  SmallVector& operator=(SmallVector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      FreeHeap();
+      TakeFrom(std::move(other));
+    }
+    return *this;
+  }
+  SmallVector& operator=(std::initializer_list<T> init) {
+    assign(init);
+    return *this;
+  }
+
+  void assign(size_type count, const T& value) {
+    // value might point into this vector, so copy it before clearing.
+    T copy(value);
+    clear();
+    reserve(count);
+    std::uninitialized_fill_n(data_, count, copy);
+    size_ = count;
+  }
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                    typename std::iterator_traits<
+                                        InputIt>::iterator_category>) {
+      reserve(std::distance(first, last));
+    }
+    for (; first != last; ++first) emplace_back(*first);
+  }
+  void assign(std::initializer_list<T> init) {
+    assign(init.begin(), init.end());
+  }
+
+  // Element access.
+  reference at(size_type pos) {
+    if (pos >= size_) throw std::out_of_range("SmallVector::at");
+    return data_[pos];
+  }
+  const_reference at(size_type pos) const {
+    if (pos >= size_) throw std::out_of_range("SmallVector::at");
+    return data_[pos];
+  }
+  reference operator[](size_type pos) { return data_[pos]; }
+  const_reference operator[](size_type pos) const { return data_[pos]; }
+  reference front() { return data_[0]; }
+  const_reference front() const { return data_[0]; }
+  reference back() { return data_[size_ - 1]; }
+  const_reference back() const { return data_[size_ - 1]; }
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+
+  // Iterators. These are plain pointers, same as most std::vector
+  // implementations in optimized builds.
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // Capacity.
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type max_size() const noexcept {
+    return std::allocator_traits<std::allocator<T>>::max_size(
+        std::allocator<T>());
+  }
+  size_type capacity() const noexcept { return capacity_; }
+  // True while the elements still fit in the inline storage.
+  bool is_inline() const noexcept { return data_ == InlineData(); }
+  static constexpr size_type inline_capacity() { return N; }
+
+  void reserve(size_type new_capacity) {
+    if (new_capacity > capacity_) Reallocate(new_capacity);
+  }
+  void shrink_to_fit() {
+    if (is_inline() || size_ == capacity_) return;
+    if (size_ <= N) {
+      // Move back into the inline storage.
+      T* heap = data_;
+      size_type heap_capacity = capacity_;
+      Relocate(heap, size_, InlineData());
+      std::allocator<T>().deallocate(heap, heap_capacity);
+      data_ = InlineData();
+      capacity_ = N;
+    } else {
+      Reallocate(size_);
+    }
+  }
+
+  // Modifiers.
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    size_ = 0;
+  }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return emplace(pos, value);
+  }
+  iterator insert(const_iterator pos, T&& value) {
+    return emplace(pos, std::move(value));
+  }
+  iterator insert(const_iterator pos, size_type count, const T& value) {
+    size_type offset = pos - begin();
+    T copy(value);
+    if (size_ + count > capacity_) {
+      Reallocate(std::max(capacity_ * 2, size_ + count));
+    }
+    for (size_type i = 0; i < count; ++i) emplace_back(copy);
+    std::rotate(begin() + offset, end() - count, end());
+    return begin() + offset;
+  }
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_type offset = pos - begin();
+    size_type old_size = size_;
+    for (; first != last; ++first) emplace_back(*first);
+    std::rotate(begin() + offset, begin() + old_size, end());
+    return begin() + offset;
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  // Adds the element at the end and rotates it into place, which is the same
+  // number of moves as shifting everything over by hand.
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    size_type offset = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + offset, end() - 1, end());
+    return begin() + offset;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator out = begin() + (first - begin());
+    if (first != last) {
+      iterator new_end = std::move(out + (last - first), end(), out);
+      std::destroy(new_end, end());
+      size_ = new_end - begin();
+    }
+    return out;
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      return GrowAndEmplaceBack(std::forward<Args>(args)...);
+    }
+    T* slot = ::new (static_cast<void*>(data_ + size_))
+        T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+
+  void pop_back() {
+    --size_;
+    std::destroy_at(data_ + size_);
+  }
+
+  void resize(size_type count) {
+    if (count < size_) {
+      erase(begin() + count, end());
+    } else {
+      reserve(count);
+      std::uninitialized_value_construct(end(), begin() + count);
+      size_ = count;
+    }
+  }
+  void resize(size_type count, const T& value) {
+    if (count < size_) {
+      erase(begin() + count, end());
+    } else {
+      insert(end(), count - size_, value);
+    }
+  }
+
+  void swap(SmallVector& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (!is_inline() && !other.is_inline()) {
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(capacity_, other.capacity_);
+      return;
+    }
+    SmallVector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+ private:
+  T* InlineData() noexcept { return reinterpret_cast<T*>(inline_); }
+  const T* InlineData() const noexcept {
+    return reinterpret_cast<const T*>(inline_);
+  }
+
+  void FreeHeap() noexcept {
+    if (!is_inline()) std::allocator<T>().deallocate(data_, capacity_);
+    data_ = InlineData();
+    capacity_ = N;
+  }
+
+  // Moves count elements from src into uninitialized memory at dst and
+  // destroys the originals. Falls back to copying if T's move constructor can
+  // throw, same as std::vector, so a throw leaves the original alone.
+  static void Relocate(T* src, size_type count, T* dst) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                  !std::is_copy_constructible_v<T>) {
+      std::uninitialized_move_n(src, count, dst);
+    } else {
+      std::uninitialized_copy_n(src, count, dst);
+    }
+    std::destroy_n(src, count);
+  }
+
+  void Reallocate(size_type new_capacity) {
+    T* new_data = std::allocator<T>().allocate(new_capacity);
+    try {
+      Relocate(data_, size_, new_data);
+    } catch (...) {
+      std::allocator<T>().deallocate(new_data, new_capacity);
+      throw;
+    }
+    FreeHeap();
+    data_ = new_data;
+    capacity_ = new_capacity;
+  }
+
+  // The new element gets constructed before the old ones are moved, in case
+  // args refers to one of them (v.push_back(v[0])).
+  template <typename... Args>
+  reference GrowAndEmplaceBack(Args&&... args) {
+    size_type new_capacity = std::max(capacity_ * 2, size_ + 1);
+    T* new_data = std::allocator<T>().allocate(new_capacity);
+    T* slot;
+    try {
+      slot = ::new (static_cast<void*>(new_data + size_))
+          T(std::forward<Args>(args)...);
+    } catch (...) {
+      std::allocator<T>().deallocate(new_data, new_capacity);
+      throw;
+    }
+    try {
+      Relocate(data_, size_, new_data);
+    } catch (...) {
+      slot->~T();
+      std::allocator<T>().deallocate(new_data, new_capacity);
+      throw;
+    }
+    FreeHeap();
+    data_ = new_data;
+    capacity_ = new_capacity;
+    ++size_;
+    return *slot;
+  }
+
+  // Steals other's heap buffer if it has one, otherwise moves its elements
+  // one by one. Expects this to be empty and inline.
+  void TakeFrom(SmallVector&& other) {
+    if (other.is_inline()) {
+      Relocate(other.data_, other.size_, data_);
+      size_ = other.size_;
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.InlineData();
+      other.capacity_ = N;
+    }
+    other.size_ = 0;
+  }
+
+  T* data_;
+  size_type size_;
+  size_type capacity_;
+  alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
+template <typename T, size_t N>
+bool operator==(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs) {
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+template <typename T, size_t N>
+bool operator!=(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs) {
+  return !(lhs == rhs);
+}
+template <typename T, size_t N>
+bool operator<(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs) {
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+                                      rhs.end());
+}
+template <typename T, size_t N>
+bool operator>(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs) {
+  return rhs < lhs;
+}
+template <typename T, size_t N>
+bool operator<=(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs) {
+  return !(rhs < lhs);
+}
+template <typename T, size_t N>
+bool operator>=(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs) {
+  return !(lhs < rhs);
+}
+
+template <typename T, size_t N>
+void swap(SmallVector<T, N>& lhs,
+          SmallVector<T, N>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+  lhs.swap(rhs);
+}
+
+#endif  // SMALL_VECTOR_H_
@@ -0,0 +1,392 @@
+#ifndef SOA_VECTOR_H_
+#define SOA_VECTOR_H_
+
+// SoaVector<T, fields...> stores a list of structs as a "struct of arrays":
+// one std::vector per field instead of one std::vector of whole structs.
+//
+// In a std::vector<Person> every Person is a 32 byte std::string next to a
+// 4 byte int (plus padding), so a loop that only looks at ages still drags
+// all the names through the cache with them, and uses 4 of every 40 bytes it
+// reads. Storing all the ages in one array of their own makes that loop read
+// only ages, 10 times less memory, and makes it a plain int array that the
+// SIMD kernels in simd_kernels.h can run over directly.
+//
+// The fields to store are given as pointers to members, and anything else in
+// T isn't kept:
+//
+//   SoaVector<Person, &Person::name, &Person::age> people;
+//   people.push_back({"Bill", 40});
+//   absl::Span<const int> ages = people.column<&Person::age>();
+//   int64_t total_age = simd::Sum(ages);
+//   people.SortBy<&Person::age>();
+//   Person first = people[0];
+//   people[0].get<&Person::age>() = 41;
+//
+// Since there's no actual Person stored anywhere, [] and the iterators give
+// out proxy objects that refer to a row, like std::vector<bool> does for
+// bits. A proxy converts to a T (by copying each field into a default
+// constructed T), can be assigned a T, and get<&T::field>() gives a real
+// reference to one field. The iterators are random access, so std algorithms
+// work on them, but a comparator or predicate taking a const Person& gets a
+// copy of every Person it's called with. For sorting use SortBy() instead,
+// which sorts by one column with StableRadixSort from radix_sort.h and then
+// moves every column into the new order once.
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "radix_sort.h"
+
+namespace soa_internal {
+
+template <typename Member>
+struct MemberPointer {};
+template <typename Class, typename Field>
+struct MemberPointer<Field Class::*> {
+  using class_type = Class;
+  using field_type = Field;
+};
+
+template <auto kA, auto kB>
+constexpr bool SameMember() {
+  if constexpr (std::is_same_v<decltype(kA), decltype(kB)>) {
+    return kA == kB;
+  } else {
+    return false;
+  }
+}
+
+}  // namespace soa_internal
+
+template <typename T, auto... kFields>
+class SoaVector {
+  static_assert(sizeof...(kFields) > 0, "SoaVector needs at least one field.");
+  static_assert(
+      (std::is_same_v<typename soa_internal::MemberPointer<
+                          decltype(kFields)>::class_type,
+                      T> &&
+       ...),
+      "SoaVector's fields have to be data members of T, like &Person::age.");
+
+  template <bool kConst>
+  class Iterator;
+
+ public:
+  // The type of a field, e.g. FieldType<&Person::age> is int.
+  template <auto kField>
+  using FieldType =
+      typename soa_internal::MemberPointer<decltype(kField)>::field_type;
+
+  class Reference;
+  class ConstReference;
+
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = Reference;
+  using const_reference = ConstReference;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  SoaVector() = default;
+  SoaVector(std::initializer_list<T> init) {
+    reserve(init.size());
+    for (const T& value : init) push_back(value);
+  }
+
+  Reference operator[](size_type pos) {
+    assert(pos < size() && "SoaVector index out of range");
+    return Reference(this, pos);
+  }
+  ConstReference operator[](size_type pos) const {
+    assert(pos < size() && "SoaVector index out of range");
+    return ConstReference(this, pos);
+  }
+  Reference front() { return (*this)[0]; }
+  ConstReference front() const { return (*this)[0]; }
+  Reference back() { return (*this)[size() - 1]; }
+  ConstReference back() const { return (*this)[size() - 1]; }
+
+  // All of one field, in order. This is what to hand to the SIMD kernels.
+  template <auto kField>
+  absl::Span<FieldType<kField>> column() {
+    return absl::MakeSpan(Column<kField>());
+  }
+  template <auto kField>
+  absl::Span<const FieldType<kField>> column() const {
+    return absl::MakeConstSpan(Column<kField>());
+  }
+
+  iterator begin() noexcept { return iterator(this, 0); }
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(this, size()); }
+  const_iterator end() const noexcept { return const_iterator(this, size()); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept { return std::get<0>(columns_).size(); }
+  void reserve(size_type new_cap) {
+    (Column<kFields>().reserve(new_cap), ...);
+  }
+  void shrink_to_fit() { (Column<kFields>().shrink_to_fit(), ...); }
+
+  void clear() noexcept { (Column<kFields>().clear(), ...); }
+  void push_back(const T& value) {
+    (Column<kFields>().push_back(value.*kFields), ...);
+  }
+  void push_back(T&& value) {
+    (Column<kFields>().push_back(std::move(value.*kFields)), ...);
+  }
+  void pop_back() {
+    assert(!empty() && "pop_back() on an empty SoaVector");
+    (Column<kFields>().pop_back(), ...);
+  }
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    const difference_type from = first - cbegin();
+    const difference_type to = last - cbegin();
+    (Column<kFields>().erase(Column<kFields>().begin() + from,
+                             Column<kFields>().begin() + to),
+     ...);
+    return iterator(this, from);
+  }
+  void resize(size_type count) { (Column<kFields>().resize(count), ...); }
+  void swap(SoaVector& other) noexcept { columns_.swap(other.columns_); }
+
+  // Sorts the rows by one field, which has to be an integer type or a
+  // string. Rows with equal keys stay in the order they were in.
+  template <auto kField>
+  void SortBy() {
+    const std::vector<FieldType<kField>>& keys = Column<kField>();
+    std::vector<size_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+    StableRadixSort(order.begin(), order.end(),
+                    [&keys](size_t row) -> const FieldType<kField>& {
+                      return keys[row];
+                    });
+    // Row order[i] goes to i. Moving the rows in input order and writing
+    // them wherever they go reads every column front to back, where reading
+    // them in output order would jump around.
+    std::vector<size_t> destination(order.size());
+    for (size_t i = 0; i < order.size(); ++i) destination[order[i]] = i;
+    (Permute(Column<kFields>(), destination), ...);
+  }
+
+  // A row of a SoaVector, standing in for a T&.
+  class Reference {
+   public:
+    Reference(SoaVector* vector, size_type index)
+        : vector_(vector), index_(index) {}
+    Reference(const Reference&) = default;
+
+    template <auto kField>
+    FieldType<kField>& get() const {
+      return vector_->template Column<kField>()[index_];
+    }
+
+    operator T() const {
+      T value;
+      ((value.*kFields = get<kFields>()), ...);
+      return value;
+    }
+
+    // Assigning to a Reference assigns to the row it refers to, like
+    // assigning through a T& would, and not to the Reference itself.
+    const Reference& operator=(const T& value) const {
+      ((get<kFields>() = value.*kFields), ...);
+      return *this;
+    }
+    const Reference& operator=(T&& value) const {
+      ((get<kFields>() = std::move(value.*kFields)), ...);
+      return *this;
+    }
+    const Reference& operator=(const Reference& other) const {
+      ((get<kFields>() = other.get<kFields>()), ...);
+      return *this;
+    }
+
+    friend void swap(const Reference& a, const Reference& b) {
+      using std::swap;
+      (swap(a.get<kFields>(), b.get<kFields>()), ...);
+    }
+
+   private:
+    friend class ConstReference;
+
+    SoaVector* vector_;
+    size_type index_;
+  };
+
+  // A row of a const SoaVector, standing in for a const T&.
+  class ConstReference {
+   public:
+    ConstReference(const SoaVector* vector, size_type index)
+        : vector_(vector), index_(index) {}
+    ConstReference(const Reference& other)
+        : vector_(other.vector_), index_(other.index_) {}
+
+    template <auto kField>
+    const FieldType<kField>& get() const {
+      return vector_->template Column<kField>()[index_];
+    }
+
+    operator T() const {
+      T value;
+      ((value.*kFields = get<kFields>()), ...);
+      return value;
+    }
+
+   private:
+    const SoaVector* vector_;
+    size_type index_;
+  };
+
+ private:
+  // Which of kFields kField is, or sizeof...(kFields) if it isn't one.
+  template <auto kField>
+  static constexpr size_t ColumnIndex() {
+    constexpr bool kMatches[] = {
+        soa_internal::SameMember<kField, kFields>()...};
+    size_t index = 0;
+    while (index < sizeof...(kFields) && !kMatches[index]) ++index;
+    return index;
+  }
+
+  template <auto kField>
+  std::vector<FieldType<kField>>& Column() {
+    static_assert(ColumnIndex<kField>() < sizeof...(kFields),
+                  "Not one of this SoaVector's fields.");
+    return std::get<ColumnIndex<kField>()>(columns_);
+  }
+  template <auto kField>
+  const std::vector<FieldType<kField>>& Column() const {
+    static_assert(ColumnIndex<kField>() < sizeof...(kFields),
+                  "Not one of this SoaVector's fields.");
+    return std::get<ColumnIndex<kField>()>(columns_);
+  }
+
+  // Moves row i of column to row destination[i].
+  template <typename Field>
+  static void Permute(std::vector<Field>& column,
+                      const std::vector<size_t>& destination) {
+    std::vector<Field> permuted(column.size());
+    for (size_t i = 0; i < column.size(); ++i) {
+      permuted[destination[i]] = std::move(column[i]);
+    }
+    column.swap(permuted);
+  }
+
+  template <bool kConst>
+  class Iterator {
+    using Vector = std::conditional_t<kConst, const SoaVector, SoaVector>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::conditional_t<kConst, ConstReference, Reference>;
+
+    Iterator() = default;
+    Iterator(Vector* vector, size_t index) : vector_(vector), index_(index) {}
+    // iterator converts to const_iterator, not the other way around.
+    template <bool kOtherConst,
+              typename = std::enable_if_t<kConst && !kOtherConst>>
+    Iterator(const Iterator<kOtherConst>& other)
+        : vector_(other.vector_), index_(other.index_) {}
+
+    reference operator*() const { return reference(vector_, index_); }
+    reference operator[](difference_type n) const {
+      return reference(vector_, index_ + n);
+    }
+
+    Iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++index_;
+      return old;
+    }
+    Iterator& operator--() {
+      --index_;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --index_;
+      return old;
+    }
+    Iterator& operator+=(difference_type n) {
+      index_ += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index_ -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator& a, const Iterator& b) {
+      return static_cast<difference_type>(a.index_) -
+             static_cast<difference_type>(b.index_);
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.index_ == b.index_;
+    }
+    friend bool operator!=(const Iterator& a, const Iterator& b) {
+      return a.index_ != b.index_;
+    }
+    friend bool operator<(const Iterator& a, const Iterator& b) {
+      return a.index_ < b.index_;
+    }
+    friend bool operator>(const Iterator& a, const Iterator& b) {
+      return a.index_ > b.index_;
+    }
+    friend bool operator<=(const Iterator& a, const Iterator& b) {
+      return a.index_ <= b.index_;
+    }
+    friend bool operator>=(const Iterator& a, const Iterator& b) {
+      return a.index_ >= b.index_;
+    }
+
+   private:
+    template <bool>
+    friend class Iterator;
+
+    Vector* vector_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  std::tuple<std::vector<FieldType<kFields>>...> columns_;
+};
+
+#endif  // SOA_VECTOR_H_
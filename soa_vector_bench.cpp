@@ -0,0 +1,143 @@
+// Scanning ages in a std::vector<Person> vs a SoaVector<Person> that keeps
+// the ages in a column of their own. Run with:
+//   bazel run -c opt :soa_vector_bench
+//
+// The 100M runs need about 4GB for the std::vector<Person>. Once neither
+// layout fits in cache, the difference is how many bytes get read per age:
+// 40 (a whole Person) vs 4.
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "person.h"
+#include "radix_sort.h"
+#include "simd_kernels.h"
+#include "soa_vector.h"
+
+namespace {
+
+using PersonColumns = SoaVector<Person, &Person::name, &Person::age>;
+
+constexpr int kRetirementAge = 65;
+
+PersonColumns MakePersonColumns(int64_t n) {
+  std::vector<Person> people = MakePeople(n);
+  PersonColumns columns;
+  columns.reserve(n);
+  for (Person& person : people) columns.push_back(std::move(person));
+  return columns;
+}
+
+void BM_SumAgesVector(benchmark::State& state) {
+  const std::vector<Person> people = MakePeople(state.range(0));
+  for (auto _ : state) {
+    int64_t total = 0;
+    for (const Person& person : people) total += person.age;
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// The same plain loop, over just the ages.
+void BM_SumAgesSoa(benchmark::State& state) {
+  const PersonColumns people = MakePersonColumns(state.range(0));
+  for (auto _ : state) {
+    int64_t total = 0;
+    for (int age : people.column<&Person::age>()) total += age;
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+void BM_SumAgesSoaSimd(benchmark::State& state) {
+  const PersonColumns people = MakePersonColumns(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::Sum(people.column<&Person::age>()));
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// Collecting every age over 65.
+void BM_FilterAgesVector(benchmark::State& state) {
+  const std::vector<Person> people = MakePeople(state.range(0));
+  std::vector<int> out(people.size());
+  for (auto _ : state) {
+    size_t count = 0;
+    for (const Person& person : people) {
+      if (person.age > kRetirementAge) out[count++] = person.age;
+    }
+    benchmark::DoNotOptimize(count);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+void BM_FilterAgesSoaSimd(benchmark::State& state) {
+  const PersonColumns people = MakePersonColumns(state.range(0));
+  std::vector<int> out(people.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(simd::FilterGreaterThan(
+        people.column<&Person::age>(), kRetirementAge, absl::MakeSpan(out)));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// Sorting by age, where the whole Person has to move and not just the age.
+void BM_SortByAgeVector(benchmark::State& state) {
+  const std::vector<Person> input = MakePeople(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Person> people = input;
+    state.ResumeTiming();
+    RadixSort(people.begin(), people.end(),
+              [](const Person& person) { return person.age; });
+    benchmark::DoNotOptimize(people.data());
+    state.PauseTiming();
+    people = {};
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// SortBy sorts row numbers by age and then moves each column into place, so
+// it makes more passes over memory than RadixSort does on the whole Persons.
+void BM_SortByAgeSoa(benchmark::State& state) {
+  const PersonColumns input = MakePersonColumns(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    PersonColumns people = input;
+    state.ResumeTiming();
+    people.SortBy<&Person::age>();
+    benchmark::DoNotOptimize(people.column<&Person::age>().data());
+    state.PauseTiming();
+    people = {};
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void ScanSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {1 << 16, 1 << 20, 10'000'000, 100'000'000}) b->Arg(n);
+  b->Unit(benchmark::kMicrosecond);
+}
+void SortSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {1 << 16, 1 << 20, 10'000'000}) b->Arg(n);
+  b->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_SumAgesVector)->Apply(ScanSizes);
+BENCHMARK(BM_SumAgesSoa)->Apply(ScanSizes);
+BENCHMARK(BM_SumAgesSoaSimd)->Apply(ScanSizes);
+BENCHMARK(BM_FilterAgesVector)->Apply(ScanSizes);
+BENCHMARK(BM_FilterAgesSoaSimd)->Apply(ScanSizes);
+BENCHMARK(BM_SortByAgeVector)->Apply(SortSizes);
+BENCHMARK(BM_SortByAgeSoa)->Apply(SortSizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();
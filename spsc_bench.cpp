@@ -0,0 +1,173 @@
+// Handoff throughput and latency between two threads for SpscQueue, against
+// a std::queue guarded by a std::mutex. Run with:
+//   bazel run -c opt :spsc_bench
+//
+// The benchmark thread is the producer, pinned to CPU 0. The consumer is a
+// second thread pinned to CPU 1. Both spin instead of sleeping while waiting,
+// which is how you'd run a pipeline stage that needs the throughput. On a
+// machine with a single CPU both end up on the same one and the numbers are
+// meaningless.
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "spsc_queue.h"
+
+namespace {
+
+constexpr size_t kQueueCapacity = 1 << 14;
+
+// The baseline: what you'd write with the std::queue from Arrays().
+template <typename T>
+class MutexQueue {
+ public:
+  explicit MutexQueue(size_t capacity) : capacity_(capacity) {}
+  bool TryPush(const T& value) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (queue_.size() >= capacity_) return false;
+    queue_.push(value);
+    return true;
+  }
+  bool TryPop(T& out) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (queue_.empty()) return false;
+    out = queue_.front();
+    queue_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mu_;
+  std::queue<T> queue_;
+  size_t capacity_;
+};
+
+// Each iteration hands one item to the consumer.
+template <typename Queue>
+void BM_Throughput(benchmark::State& state) {
+  Queue queue(kQueueCapacity);
+  std::atomic<bool> done{false};
+  std::thread consumer([&] {
+    PinThisThread(1);
+    int64_t sum = 0;
+    int64_t item;
+    int spins = 0;
+    while (true) {
+      if (queue.TryPop(item)) {
+        sum += item;
+      } else if (done.load(std::memory_order_acquire)) {
+        // Drain whatever was pushed before done was set.
+        while (queue.TryPop(item)) sum += item;
+        break;
+      } else {
+        SpinWait(spins);
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  });
+  PinThisThread(0);
+  int64_t i = 0;
+  int spins = 0;
+  for (auto _ : state) {
+    while (!queue.TryPush(i)) SpinWait(spins);
+    ++i;
+  }
+  done.store(true, std::memory_order_release);
+  consumer.join();
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same thing using the batch calls, `batch` items at a time. Each iteration
+// is one item so the numbers line up with BM_Throughput.
+void BM_BatchThroughput(benchmark::State& state) {
+  const size_t batch = state.range(0);
+  SpscQueue<int64_t> queue(kQueueCapacity);
+  std::atomic<bool> done{false};
+  std::thread consumer([&] {
+    PinThisThread(1);
+    std::vector<int64_t> items(batch);
+    int64_t sum = 0;
+    int spins = 0;
+    while (true) {
+      size_t n = queue.TryPopBatch(items.data(), batch);
+      for (size_t i = 0; i < n; ++i) sum += items[i];
+      if (n == 0) {
+        if (done.load(std::memory_order_acquire) && queue.size_approx() == 0) {
+          break;
+        }
+        SpinWait(spins);
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  });
+  PinThisThread(0);
+  std::vector<int64_t> items(batch, 1);
+  size_t pending = 0;
+  int spins = 0;
+  for (auto _ : state) {
+    if (++pending == batch) {
+      size_t pushed = 0;
+      while (pushed < batch) {
+        size_t n = queue.TryPushBatch(items.data() + pushed, batch - pushed);
+        if (n == 0) SpinWait(spins);
+        pushed += n;
+      }
+      pending = 0;
+    }
+  }
+  done.store(true, std::memory_order_release);
+  consumer.join();
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Round trip: send an item over one queue, the other thread sends it straight
+// back over a second queue. Half the time per iteration is the one-way
+// latency.
+template <typename Queue>
+void BM_PingPong(benchmark::State& state) {
+  Queue ping(kQueueCapacity);
+  Queue pong(kQueueCapacity);
+  std::atomic<bool> done{false};
+  std::thread echo([&] {
+    PinThisThread(1);
+    int64_t item;
+    int spins = 0;
+    while (!done.load(std::memory_order_relaxed)) {
+      if (ping.TryPop(item)) {
+        while (!pong.TryPush(item)) SpinWait(spins);
+      } else {
+        SpinWait(spins);
+      }
+    }
+  });
+  PinThisThread(0);
+  int64_t item = 0;
+  int spins = 0;
+  for (auto _ : state) {
+    while (!ping.TryPush(item)) SpinWait(spins);
+    while (!pong.TryPop(item)) SpinWait(spins);
+  }
+  done.store(true, std::memory_order_relaxed);
+  echo.join();
+  // Each iteration is two hops, and kIsRate | kInvert reports elapsed time
+  // divided by the value, so this is the time per hop, e.g. one_way=1.1us.
+  state.counters["one_way"] = benchmark::Counter(
+      state.iterations() * 2,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK_TEMPLATE(BM_Throughput, SpscQueue<int64_t>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Throughput, MutexQueue<int64_t>)->UseRealTime();
+BENCHMARK(BM_BatchThroughput)->RangeMultiplier(4)->Range(4, 256)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PingPong, SpscQueue<int64_t>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PingPong, MutexQueue<int64_t>)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,166 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+// SpscQueue<T> is a fixed-size queue for handing items from exactly one
+// producer thread to exactly one consumer thread, without locks.
+//
+// It's a ring buffer with two counters: the producer only ever writes `tail`
+// and the consumer only ever writes `head`. Each side reads the other's
+// counter to see how much room or data there is. Because each counter has a
+// single writer, plain atomic loads and stores are enough, no compare and
+// swap loops and no mutex. The release store after writing a slot and the
+// acquire load before reading it are what make the item itself visible to
+// the other thread.
+//
+// The two counters are kept on separate cache lines. Otherwise every push
+// would steal the cache line from the consumer and every pop would steal it
+// back ("false sharing"), which is most of what makes naive queues slow. Each
+// side also keeps a private cached copy of the other side's counter and only
+// re-reads the shared one when the cached value says the queue looks
+// full/empty.
+//
+//   SpscQueue<int> queue(1024);
+//   // Producer thread:
+//   while (!queue.TryPush(5)) {}
+//   // Consumer thread:
+//   int x;
+//   if (queue.TryPop(x)) ...
+//
+// Using it from more than one producer or more than one consumer at a time is
+// a data race. See MpmcQueue for that.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename T>
+class SpscQueue {
+ public:
+  // The capacity gets rounded up to a power of two so wrapping around is a
+  // mask instead of a division.
+  explicit SpscQueue(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1),
+        slots_(static_cast<T*>(::operator new(
+            (mask_ + 1) * sizeof(T), std::align_val_t(alignof(T))))) {}
+
+  ~SpscQueue() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; head != tail; ++head) std::destroy_at(&slots_[head & mask_]);
+    ::operator delete(slots_, std::align_val_t(alignof(T)));
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer side. Returns false without doing anything if the queue is full.
+  bool TryPush(const T& value) { return TryEmplace(value); }
+  bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+  template <typename... Args>
+  bool TryEmplace(Args&&... args) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) return false;
+    }
+    ::new (static_cast<void*>(&slots_[tail & mask_]))
+        T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pushes as many of items[0..count) as there's room for and returns how
+  // many that was. All of them become visible to the consumer at once, with a
+  // single atomic store, which is much cheaper per item than TryPush.
+  size_t TryPushBatch(const T* items, size_t count) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t room = mask_ + 1 - (tail - cached_head_);
+    if (room < count) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      room = mask_ + 1 - (tail - cached_head_);
+    }
+    const size_t n = std::min(room, count);
+    for (size_t i = 0; i < n; ++i) {
+      ::new (static_cast<void*>(&slots_[(tail + i) & mask_])) T(items[i]);
+    }
+    if (n > 0) tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer side. Returns false without doing anything if the queue is
+  // empty.
+  bool TryPop(T& out) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) return false;
+    }
+    T& slot = slots_[head & mask_];
+    out = std::move(slot);
+    std::destroy_at(&slot);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pops up to max_count items into out[0..max_count) and returns how many.
+  size_t TryPopBatch(T* out, size_t max_count) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    size_t available = cached_tail_ - head;
+    if (available < max_count) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      available = cached_tail_ - head;
+    }
+    const size_t n = std::min(available, max_count);
+    for (size_t i = 0; i < n; ++i) {
+      T& slot = slots_[(head + i) & mask_];
+      out[i] = std::move(slot);
+      std::destroy_at(&slot);
+    }
+    if (n > 0) head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Only a snapshot, since the other thread can change it right after. Safe
+  // to call from any thread. head_ is read first: tail_ only ever moves
+  // forward, so a tail_ read afterwards can't be behind it. It can be ahead
+  // by more than the capacity if both sides kept going in between, hence the
+  // clamp.
+  size_t size_approx() const {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return std::min(tail - head, capacity());
+  }
+
+ private:
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) power <<= 1;
+    return power;
+  }
+
+  // 64 bytes on x86 and most ARM. std::hardware_destructive_interference_size
+  // would be the portable way, but compilers warn about it changing between
+  // versions, which matters for a header.
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Read-only after construction, so it's fine for both threads to share the
+  // line these are on.
+  const size_t mask_;
+  T* const slots_;
+
+  // Written by the consumer.
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+
+  // Written by the producer.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+};
+
+#endif  // SPSC_QUEUE_H_
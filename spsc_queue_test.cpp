@@ -0,0 +1,139 @@
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(SpscQueueTest, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(SpscQueue<int>(5).capacity(), 8);
+  EXPECT_EQ(SpscQueue<int>(8).capacity(), 8);
+  EXPECT_EQ(SpscQueue<int>(0).capacity(), 2);
+}
+
+TEST(SpscQueueTest, FullAndEmpty) {
+  SpscQueue<int> queue(4);
+  int x;
+  EXPECT_FALSE(queue.TryPop(x));
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.TryPush(i));
+  EXPECT_FALSE(queue.TryPush(4));
+  EXPECT_EQ(queue.size_approx(), 4);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.TryPop(x));
+    EXPECT_EQ(x, i);
+  }
+  EXPECT_FALSE(queue.TryPop(x));
+  EXPECT_EQ(queue.size_approx(), 0);
+}
+
+// Pushing and popping a few at a time goes around the ring many times, with
+// the counters ending up at every offset from the end of the buffer.
+TEST(SpscQueueTest, WrapsAround) {
+  SpscQueue<int> queue(4);
+  int next_push = 0;
+  int next_pop = 0;
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(queue.TryPush(next_push++));
+    for (int i = 0; i < 2 + round % 2; ++i) {
+      int x;
+      ASSERT_TRUE(queue.TryPop(x));
+      EXPECT_EQ(x, next_pop++);
+    }
+    int x;
+    if (queue.size_approx() == 1) {
+      ASSERT_TRUE(queue.TryPop(x));
+      EXPECT_EQ(x, next_pop++);
+    }
+    EXPECT_EQ(queue.size_approx(), 0);
+  }
+}
+
+TEST(SpscQueueTest, BatchesWrapAroundAndStopWhenFull) {
+  SpscQueue<int> queue(8);
+  std::vector<int> items = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  EXPECT_EQ(queue.TryPushBatch(items.data(), 5), 5);
+  int out[10];
+  ASSERT_EQ(queue.TryPopBatch(out, 3), 3);
+  EXPECT_EQ(out[0], 0);
+  EXPECT_EQ(out[2], 2);
+
+  // 2 left in the queue, so only 6 of these 7 fit, and they wrap past the
+  // end of the buffer.
+  EXPECT_EQ(queue.TryPushBatch(items.data() + 5, 7), 6);
+  EXPECT_EQ(queue.size_approx(), 8);
+  EXPECT_EQ(queue.TryPushBatch(items.data(), 1), 0);
+
+  ASSERT_EQ(queue.TryPopBatch(out, 10), 8);
+  const int expected[] = {3, 4, 5, 6, 7, 8, 9, 10};
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(out[i], expected[i]);
+  EXPECT_EQ(queue.TryPopBatch(out, 10), 0);
+}
+
+TEST(SpscQueueTest, DestroysLeftoverItems) {
+  auto item = std::make_shared<int>(1);
+  {
+    SpscQueue<std::shared_ptr<int>> queue(4);
+    // Wrap around first so the leftovers straddle the end of the buffer.
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(queue.TryPush(item));
+      std::shared_ptr<int> out;
+      ASSERT_TRUE(queue.TryPop(out));
+    }
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(queue.TryPush(item));
+    EXPECT_EQ(item.use_count(), 4);
+  }
+  EXPECT_EQ(item.use_count(), 1);
+}
+
+// A producer and a consumer mixing single and batch calls, with a third
+// thread watching size_approx(), which has to stay within the capacity.
+TEST(SpscQueueTest, TwoThreadsKeepOrder) {
+  constexpr int64_t kNumItems = 200'000;
+  SpscQueue<int64_t> queue(64);
+  std::atomic<bool> done{false};
+
+  std::thread producer([&] {
+    int64_t next = 0;
+    int64_t batch[16];
+    while (next < kNumItems) {
+      size_t pushed;
+      if (next % 3 == 0) {
+        pushed = queue.TryPush(next) ? 1 : 0;
+      } else {
+        int64_t count = std::min<int64_t>(16, kNumItems - next);
+        for (int64_t i = 0; i < count; ++i) batch[i] = next + i;
+        pushed = queue.TryPushBatch(batch, count);
+      }
+      next += pushed;
+      // Let the consumer run on machines with fewer cores than threads.
+      if (pushed == 0) std::this_thread::yield();
+    }
+  });
+  std::thread monitor([&] {
+    while (!done.load(std::memory_order_relaxed)) {
+      ASSERT_LE(queue.size_approx(), queue.capacity());
+      std::this_thread::yield();
+    }
+  });
+
+  int64_t expected = 0;
+  int64_t out[16];
+  while (expected < kNumItems) {
+    size_t n = queue.TryPopBatch(out, expected % 2 == 0 ? 16 : 1);
+    for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], expected++);
+    if (n == 0) std::this_thread::yield();
+  }
+  producer.join();
+  done.store(true, std::memory_order_relaxed);
+  monitor.join();
+  int64_t x;
+  EXPECT_FALSE(queue.TryPop(x));
+}
+
+}  // namespace
@@ -0,0 +1,159 @@
+#ifndef STATIC_VECTOR_H_
+#define STATIC_VECTOR_H_
+
+// StaticVector<T, N> is the safe version of `int my_nums[10]` from Arrays().
+// It holds up to N elements inside the object itself and never touches the
+// heap, but unlike a raw array it keeps track of how many elements you've
+// actually put in and has push_back/pop_back like a vector.
+//
+// Going past N is a bug. Debug builds check for it with assert() so you find
+// out right away. Optimized builds (-c opt, which defines NDEBUG) skip the
+// checks so it's exactly as fast as a raw array plus a counter. If you can't
+// guarantee the size, use SmallVector, which spills to the heap instead.
+//
+//   StaticVector<int, 16> scratch;
+//   scratch.push_back(5);
+//   scratch.push_back(7);
+//   for (int x : scratch) ...
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename T, size_t N>
+class StaticVector {
+  static_assert(N > 0, "StaticVector needs room for at least one element.");
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  StaticVector() noexcept = default;
+  StaticVector(std::initializer_list<T> init) {
+    assert(init.size() <= N && "StaticVector is full");
+    std::uninitialized_copy(init.begin(), init.end(), data());
+    size_ = init.size();
+  }
+  StaticVector(const StaticVector& other) {
+    std::uninitialized_copy(other.begin(), other.end(), data());
+    size_ = other.size_;
+  }
+  StaticVector(StaticVector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    std::uninitialized_move(other.begin(), other.end(), data());
+    size_ = other.size_;
+  }
+  ~StaticVector() { clear(); }
+
+  StaticVector& operator=(const StaticVector& other) {
+    if (this != &other) {
+      clear();
+      std::uninitialized_copy(other.begin(), other.end(), data());
+      size_ = other.size_;
+    }
+    return *this;
+  }
+  StaticVector& operator=(StaticVector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      std::uninitialized_move(other.begin(), other.end(), data());
+      size_ = other.size_;
+    }
+    return *this;
+  }
+
+  // Element access. Like everything else, indexes are only checked in debug
+  // builds.
+  reference operator[](size_type pos) {
+    assert(pos < size_ && "StaticVector index out of range");
+    return data()[pos];
+  }
+  const_reference operator[](size_type pos) const {
+    assert(pos < size_ && "StaticVector index out of range");
+    return data()[pos];
+  }
+  reference front() { return (*this)[0]; }
+  const_reference front() const { return (*this)[0]; }
+  reference back() { return (*this)[size_ - 1]; }
+  const_reference back() const { return (*this)[size_ - 1]; }
+  T* data() noexcept { return reinterpret_cast<T*>(storage_); }
+  const T* data() const noexcept {
+    return reinterpret_cast<const T*>(storage_);
+  }
+
+  iterator begin() noexcept { return data(); }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator cbegin() const noexcept { return data(); }
+  iterator end() noexcept { return data() + size_; }
+  const_iterator end() const noexcept { return data() + size_; }
+  const_iterator cend() const noexcept { return data() + size_; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  bool empty() const noexcept { return size_ == 0; }
+  bool full() const noexcept { return size_ == N; }
+  size_type size() const noexcept { return size_; }
+  static constexpr size_type capacity() noexcept { return N; }
+  static constexpr size_type max_size() noexcept { return N; }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    assert(size_ < N && "StaticVector is full");
+    T* slot = ::new (static_cast<void*>(data() + size_))
+        T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+
+  void pop_back() {
+    assert(size_ > 0 && "pop_back on empty StaticVector");
+    --size_;
+    std::destroy_at(data() + size_);
+  }
+
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    size_ = 0;
+  }
+
+  // Growing value-initializes the new elements, same as std::vector.
+  void resize(size_type count) {
+    assert(count <= N && "StaticVector is full");
+    if (count < size_) {
+      std::destroy(begin() + count, end());
+    } else {
+      std::uninitialized_value_construct(end(), begin() + count);
+    }
+    size_ = count;
+  }
+
+ private:
+  alignas(T) unsigned char storage_[N * sizeof(T)];
+  size_type size_ = 0;
+};
+
+#endif  // STATIC_VECTOR_H_
@@ -0,0 +1,71 @@
+// Fixed-size scratch buffers in a hot loop: raw array, StaticVector and a
+// std::vector that gets made fresh each time. Run with:
+//   bazel run -c opt :static_vector_bench
+// StaticVector should match the raw array in opt builds.
+
+#include <cstdint>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "benchmark/benchmark.h"
+#include "static_vector.h"
+
+namespace {
+
+constexpr int kScratchSize = 64;
+
+// Fills the scratch buffer with the values of `input` that pass a filter and
+// sums them, which is the usual shape of the latency-critical loops.
+int64_t FilterRawArray(const std::vector<int>& input) {
+  int scratch[kScratchSize];
+  int count = 0;
+  for (int x : input) {
+    if (x % 3 != 0 && count < kScratchSize) scratch[count++] = x;
+  }
+  int64_t sum = 0;
+  for (int i = 0; i < count; ++i) sum += scratch[i];
+  return sum;
+}
+
+template <typename Vector>
+int64_t FilterInto(const std::vector<int>& input) {
+  Vector scratch;
+  for (int x : input) {
+    if (x % 3 != 0 && scratch.size() < kScratchSize) scratch.push_back(x);
+  }
+  int64_t sum = 0;
+  for (int x : scratch) sum += x;
+  return sum;
+}
+
+std::vector<int> MakeInput(int size) {
+  std::vector<int> input(size);
+  for (int i = 0; i < size; ++i) input[i] = i * 7;
+  return input;
+}
+
+void BM_RawArray(benchmark::State& state) {
+  std::vector<int> input = MakeInput(state.range(0));
+  for (auto _ : state) benchmark::DoNotOptimize(FilterRawArray(input));
+}
+
+template <typename Vector>
+void BM_Scratch(benchmark::State& state) {
+  std::vector<int> input = MakeInput(state.range(0));
+  AllocStats before = GetAllocStats();
+  for (auto _ : state) benchmark::DoNotOptimize(FilterInto<Vector>(input));
+  state.counters["allocs_per_iter"] = benchmark::Counter(
+      GetAllocStats().allocations - before.allocations,
+      benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_RawArray)->Arg(8)->Arg(32)->Arg(96);
+BENCHMARK_TEMPLATE(BM_Scratch, StaticVector<int, kScratchSize>)
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(96);
+BENCHMARK_TEMPLATE(BM_Scratch, std::vector<int>)->Arg(8)->Arg(32)->Arg(96);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,151 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include "absl/container/flat_hash_set.h"
+#include "arena.h"
+
+namespace {
+
+// A string being looked up, with its hash already worked out since picking
+// the shard needed it anyway.
+struct Lookup {
+  std::string_view str;
+  size_t hash;
+};
+
+// A shard's hash set holds just the ids, and hashes and compares them by
+// their strings. Looking up a Lookup works too (that's what is_transparent
+// turns on), so finding a string doesn't need a copy of it or a second hash.
+struct IdHash {
+  using is_transparent = void;
+  size_t operator()(uint32_t id) const {
+    return absl::Hash<std::string_view>{}((*pool)[StringId{id}]);
+  }
+  size_t operator()(const Lookup& lookup) const { return lookup.hash; }
+  const StringPool* pool;
+};
+
+struct IdEq {
+  using is_transparent = void;
+  bool operator()(uint32_t lhs, uint32_t rhs) const { return lhs == rhs; }
+  bool operator()(uint32_t id, const Lookup& lookup) const {
+    return (*pool)[StringId{id}] == lookup.str;
+  }
+  bool operator()(const Lookup& lookup, uint32_t id) const {
+    return (*pool)[StringId{id}] == lookup.str;
+  }
+  const StringPool* pool;
+};
+
+// absl::flat_hash_set uses the low bits of the hash inside each table, so
+// the shard comes from the top ones.
+int ShardOf(size_t hash) {
+  return static_cast<int>(hash >> (std::numeric_limits<size_t>::digits - 6));
+}
+
+}  // namespace
+
+// On its own cache line so threads locking neighbouring shards don't slow
+// each other down.
+struct alignas(64) StringPool::Shard {
+  explicit Shard(const StringPool* pool)
+      : ids(0, IdHash{pool}, IdEq{pool}) {}
+
+  std::mutex mu;
+  Arena arena;
+  absl::flat_hash_set<uint32_t, IdHash, IdEq> ids;
+};
+
+StringPool::StringPool() {
+  static_assert(kShardBits == 6, "ShardOf() assumes 64 shards.");
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    shard = std::make_unique<Shard>(this);
+  }
+}
+
+StringPool::~StringPool() {
+  for (std::atomic<std::string_view*>& chunk : chunks_) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+StringId StringPool::Intern(std::string_view str) {
+  const Lookup lookup{str, absl::Hash<std::string_view>{}(str)};
+  Shard& shard = *shards_[ShardOf(lookup.hash)];
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto it = shard.ids.find(lookup);
+  if (it != shard.ids.end()) return StringId{*it};
+  // Add can throw, so it can't run inside lazy_emplace's callback: by then
+  // the set has already counted the slot as taken, and a throw would leave
+  // garbage in it. The second lookup only happens for new strings.
+  const uint32_t id = Add(str, shard);
+  shard.ids.lazy_emplace(lookup,
+                         [&](const auto& construct) { construct(id); });
+  return StringId{id};
+}
+
+std::optional<StringId> StringPool::Find(std::string_view str) const {
+  const Lookup lookup{str, absl::Hash<std::string_view>{}(str)};
+  Shard& shard = *shards_[ShardOf(lookup.hash)];
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto it = shard.ids.find(lookup);
+  if (it == shard.ids.end()) return std::nullopt;
+  return StringId{*it};
+}
+
+uint32_t StringPool::Add(std::string_view str, Shard& shard) {
+  // Ids come from one counter shared by all the shards, which is the only
+  // thing they contend on, and only for strings that are new.
+  const uint64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+  if (id >= kMaxSize) throw std::length_error("StringPool is full");
+  // "" has nothing to copy, and shouldn't start a new arena block.
+  std::string_view stored;
+  if (!str.empty()) {
+    char* chars = static_cast<char*>(shard.arena.Allocate(str.size(), 1));
+    std::memcpy(chars, str.data(), str.size());
+    stored = std::string_view(chars, str.size());
+  }
+  const int chunk = ChunkOf(id);
+  GetOrAllocateChunk(chunk)[id - ChunkStart(chunk)] = stored;
+  return static_cast<uint32_t>(id);
+}
+
+std::string_view* StringPool::GetOrAllocateChunk(int chunk) {
+  std::string_view* entries = chunks_[chunk].load(std::memory_order_acquire);
+  if (entries != nullptr) return entries;
+  // Two shards can both get the first ids of a new chunk at the same time.
+  // Whichever installs its chunk first wins and the other one's is thrown
+  // away.
+  auto* allocated = new std::string_view[ChunkSize(chunk)];
+  if (chunks_[chunk].compare_exchange_strong(entries, allocated,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+    return allocated;
+  }
+  delete[] allocated;
+  return entries;
+}
+
+size_t StringPool::size() const {
+  return std::min(next_id_.load(std::memory_order_relaxed), kMaxSize);
+}
+
+size_t StringPool::bytes_used() const {
+  size_t bytes = kNumShards * sizeof(Shard);
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mu);
+    bytes += shard->arena.bytes_reserved() +
+             shard->ids.capacity() * (sizeof(uint32_t) + 1);
+  }
+  for (int chunk = 0; chunk < kNumChunks; ++chunk) {
+    if (chunks_[chunk].load(std::memory_order_acquire) != nullptr) {
+      bytes += ChunkSize(chunk) * sizeof(std::string_view);
+    }
+  }
+  return bytes;
+}
@@ -0,0 +1,132 @@
+#ifndef STRING_POOL_H_
+#define STRING_POOL_H_
+
+// StringPool stores each different string once and gives it a 32-bit id.
+//
+// In main.cpp "Bill" is in ages, names, unordered_names and people_set, and
+// each of them holds its own std::string copy of it. With 10M different
+// names referenced billions of times, those copies are most of the memory,
+// and comparing or hashing them reads the characters every time. Intern the
+// string instead and keep its StringId: it's 4 bytes, and two ids are equal
+// exactly when their strings are, so comparing and hashing them costs the
+// same as for an int.
+//
+//   StringPool pool;
+//   StringId bill = pool.Intern("Bill");
+//   pool.Intern("Bill") == bill;         // true
+//   std::string_view name = pool[bill];  // "Bill"
+//   absl::flat_hash_set<StringId> ids = {bill};
+//
+// Ids are handed out as 0, 1, 2, ... in the order strings are first seen, so
+// they also work as indexes into a vector of per-string data. Ordering them
+// with < is by id, not alphabetical. The characters are copied into arenas
+// owned by the pool, and nothing is ever removed, so ids and the
+// string_views from [] stay valid for as long as the pool exists.
+//
+// Everything is thread safe. The strings are split into 64 shards by hash,
+// each with its own mutex, so threads interning different strings rarely
+// wait for each other. Going from an id back to the string doesn't lock at
+// all: the pool keeps its strings in chunks that double in size and never
+// move (like SegmentedVector), so it's a leading zero count and two array
+// lookups. Like any other data, an id has to get to another thread through
+// something synchronized (a queue, a mutex, ...) before that thread looks it
+// up.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "absl/hash/hash.h"
+
+struct StringId {
+  uint32_t value;
+
+  friend bool operator==(StringId lhs, StringId rhs) {
+    return lhs.value == rhs.value;
+  }
+  friend bool operator!=(StringId lhs, StringId rhs) {
+    return lhs.value != rhs.value;
+  }
+  friend bool operator<(StringId lhs, StringId rhs) {
+    return lhs.value < rhs.value;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, StringId id) {
+    return H::combine(std::move(h), id.value);
+  }
+};
+
+// std::hash of an integer is usually the integer itself, and ids are a run
+// of consecutive numbers, which absl::flat_hash_set (it uses some of the
+// hash's bits to pick a group and others to tell elements apart) handles
+// very badly. absl::Hash mixes the bits up first.
+namespace std {
+template <>
+struct hash<StringId> {
+  size_t operator()(StringId id) const { return absl::Hash<StringId>{}(id); }
+};
+}  // namespace std
+
+class StringPool {
+ public:
+  StringPool();
+  ~StringPool();
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // The id for `str`, adding it to the pool if it isn't there yet. Throws
+  // std::length_error if the pool already has 2^32 - 1024 strings.
+  StringId Intern(std::string_view str);
+  // The id for `str` if it has been interned, without adding it.
+  std::optional<StringId> Find(std::string_view str) const;
+
+  // The string for an id this pool handed out.
+  std::string_view operator[](StringId id) const {
+    const int chunk = ChunkOf(id.value);
+    return chunks_[chunk].load(std::memory_order_acquire)
+        [id.value - ChunkStart(chunk)];
+  }
+
+  // Number of different strings.
+  size_t size() const;
+  // Bytes of heap memory used, for the characters, the id to string chunks
+  // and the hash tables that find them.
+  size_t bytes_used() const;
+
+ private:
+  struct Shard;
+
+  static constexpr int kShardBits = 6;
+  static constexpr int kNumShards = 1 << kShardBits;
+  // Chunk k holds kFirstChunkSize * 2^k strings, so 22 chunks are enough
+  // for almost every 32-bit id.
+  static constexpr uint64_t kFirstChunkSize = 1024;
+  static constexpr int kNumChunks = 22;
+  static constexpr uint64_t kMaxSize =
+      kFirstChunkSize * ((uint64_t{1} << kNumChunks) - 1);
+
+  static int ChunkOf(uint64_t id) {
+    return 63 - __builtin_clzll(id / kFirstChunkSize + 1);
+  }
+  static uint64_t ChunkStart(int chunk) {
+    return kFirstChunkSize * ((uint64_t{1} << chunk) - 1);
+  }
+  static uint64_t ChunkSize(int chunk) { return kFirstChunkSize << chunk; }
+
+  // Gives `str` a new id. Called with the shard's mutex held.
+  uint32_t Add(std::string_view str, Shard& shard);
+  // The chunk, allocating it if nobody has yet.
+  std::string_view* GetOrAllocateChunk(int chunk);
+
+  std::unique_ptr<Shard> shards_[kNumShards];
+  std::atomic<uint64_t> next_id_{0};
+  std::atomic<std::string_view*> chunks_[kNumChunks] = {};
+};
+
+#endif  // STRING_POOL_H_
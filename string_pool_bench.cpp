@@ -0,0 +1,174 @@
+// StringPool vs the obvious alternatives. Run with:
+//   bazel run -c opt :string_pool_bench
+//
+// The argument is the number of different strings. BM_Intern* interns
+// strings that are already in the pool, which is the common case once a
+// program has seen its names, spread over 1 to 8 threads. LockedInterner is
+// the simplest thread safe version: one mutex around a hash map. BM_Lookup*
+// goes from an id back to its string, and BM_SetFind* compares a hash set of
+// ids with one of the strings themselves.
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "bench_util.h"
+#include "benchmark/benchmark.h"
+#include "string_pool.h"
+
+namespace {
+
+class LockedInterner {
+ public:
+  StringId Intern(const std::string& str) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = ids_.find(str);
+    if (it == ids_.end()) {
+      it = ids_.emplace(str, static_cast<uint32_t>(ids_.size())).first;
+    }
+    return StringId{it->second};
+  }
+
+ private:
+  std::mutex mu_;
+  absl::flat_hash_map<std::string, uint32_t> ids_;
+};
+
+// n different strings in scrambled order, made once per size and shared by
+// every benchmark and thread.
+const std::vector<std::string>& Strings(int64_t n) {
+  static auto* strings = new std::map<int64_t, std::vector<std::string>>;
+  std::vector<std::string>& result = (*strings)[n];
+  if (result.empty()) {
+    ScrambledOrder order(n);
+    result.reserve(n);
+    for (int64_t i = 0; i < n; ++i) {
+      result.push_back(MakeKey<std::string>(order[i]));
+    }
+  }
+  return result;
+}
+
+template <typename Interner>
+void BM_Intern(benchmark::State& state) {
+  // Thread 0 sets up and the others wait for it at the start of the loop.
+  static std::unique_ptr<Interner> interner;
+  static const std::vector<std::string>* strings;
+  if (state.thread_index() == 0) {
+    strings = &Strings(state.range(0));
+    interner = std::make_unique<Interner>();
+    for (const std::string& str : *strings) interner->Intern(str);
+  }
+  // Each thread starts at a different place so they aren't all hitting the
+  // same shard at the same time.
+  const size_t n = state.range(0);
+  size_t i = state.thread_index() * n / state.threads();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interner->Intern((*strings)[i]));
+    if (++i == n) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) interner.reset();
+}
+
+void BM_InternNewStringPool(benchmark::State& state) {
+  const std::vector<std::string>& strings = Strings(state.range(0));
+  for (auto _ : state) {
+    StringPool pool;
+    for (const std::string& str : strings) {
+      benchmark::DoNotOptimize(pool.Intern(str));
+    }
+    state.PauseTiming();
+    state.counters["bytes_per_string"] =
+        static_cast<double>(pool.bytes_used()) / strings.size();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * strings.size());
+}
+
+void BM_InternNewLocked(benchmark::State& state) {
+  const std::vector<std::string>& strings = Strings(state.range(0));
+  for (auto _ : state) {
+    LockedInterner interner;
+    for (const std::string& str : strings) {
+      benchmark::DoNotOptimize(interner.Intern(str));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * strings.size());
+}
+
+void BM_LookupStringPool(benchmark::State& state) {
+  const std::vector<std::string>& strings = Strings(state.range(0));
+  // Ids are handed out in order, so strings[i] gets id i. Both lookups visit
+  // all n in scrambled order, so they jump around memory the same way.
+  StringPool pool;
+  for (const std::string& str : strings) pool.Intern(str);
+  const std::vector<uint32_t> indexes =
+      ScrambledIndexes(strings.size(), strings.size());
+  size_t total = 0;
+  for (auto _ : state) {
+    for (uint32_t i : indexes) total += pool[StringId{i}].size();
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations() * indexes.size());
+}
+
+void BM_LookupVector(benchmark::State& state) {
+  const std::vector<std::string>& strings = Strings(state.range(0));
+  const std::vector<uint32_t> indexes =
+      ScrambledIndexes(strings.size(), strings.size());
+  size_t total = 0;
+  for (auto _ : state) {
+    for (uint32_t i : indexes) total += strings[i].size();
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations() * indexes.size());
+}
+
+void BM_SetFindStringId(benchmark::State& state) {
+  const std::vector<std::string>& strings = Strings(state.range(0));
+  StringPool pool;
+  std::vector<StringId> ids;
+  ids.reserve(strings.size());
+  for (const std::string& str : strings) ids.push_back(pool.Intern(str));
+  const absl::flat_hash_set<StringId> set(ids.begin(), ids.end());
+  int64_t found = 0;
+  for (auto _ : state) {
+    for (StringId id : ids) found += set.contains(id);
+  }
+  benchmark::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+void BM_SetFindString(benchmark::State& state) {
+  const std::vector<std::string>& strings = Strings(state.range(0));
+  const absl::flat_hash_set<std::string> set(strings.begin(), strings.end());
+  int64_t found = 0;
+  for (auto _ : state) {
+    for (const std::string& str : strings) found += set.contains(str);
+  }
+  benchmark::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations() * strings.size());
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {1 << 10, 1 << 16, 1 << 20, 10'000'000}) b->Arg(n);
+}
+
+BENCHMARK_TEMPLATE(BM_Intern, StringPool)->Apply(Sizes)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_Intern, LockedInterner)->Apply(Sizes)->ThreadRange(1, 8);
+BENCHMARK(BM_InternNewStringPool)->Apply(Sizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InternNewLocked)->Apply(Sizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LookupStringPool)->Apply(Sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LookupVector)->Apply(Sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SetFindStringId)->Apply(Sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SetFindString)->Apply(Sizes)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
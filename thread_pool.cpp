@@ -0,0 +1,135 @@
+#include "thread_pool.h"
+
+#include <functional>
+
+namespace {
+
+// Big enough that a thread outside the pool never waits on it in practice,
+// since each ParallelFor only injects its first task.
+constexpr size_t kInjectedCapacity = 1024;
+
+// How many times an idle worker looks for work before going to sleep.
+constexpr int kSpinsBeforeSleep = 64;
+
+// The pool and worker index of the calling thread, if it's a worker.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int current_index = -1;
+
+// Cheap per-thread random numbers for picking who to steal from.
+uint32_t NextRandom() {
+  thread_local uint32_t state =
+      static_cast<uint32_t>(std::hash<std::thread::id>()(
+          std::this_thread::get_id())) |
+      1;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(int num_threads) : injected_(kInjectedCapacity) {
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Only start the threads once every deque exists, since they steal from
+  // each other right away.
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) thread.join();
+}
+
+ThreadPool& ThreadPool::Default() {
+  static ThreadPool* pool = new ThreadPool;
+  return *pool;
+}
+
+int ThreadPool::CurrentWorkerIndex() const {
+  return current_pool == this ? current_index : -1;
+}
+
+void ThreadPool::Spawn(Task* task) {
+  int index = CurrentWorkerIndex();
+  if (index >= 0) {
+    workers_[index]->deque.Push(task);
+  } else {
+    injected_.Push(task);
+  }
+  // Pairs with WorkerLoop bumping num_sleeping_ and then checking epoch_.
+  // Both are seq_cst, so either we see the sleeper or it sees the new epoch.
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  if (num_sleeping_.load(std::memory_order_seq_cst) > 0) {
+    std::lock_guard<std::mutex> lock(mu_);
+    wake_.notify_one();
+  }
+}
+
+ThreadPool::Task* ThreadPool::FindTask(int index) {
+  Task* task;
+  if (index >= 0 && workers_[index]->deque.Pop(task)) return task;
+  if (injected_.TryPop(task)) return task;
+  // Start at a random victim so thieves don't all pile onto worker 0.
+  const int num_workers = static_cast<int>(workers_.size());
+  const int start = NextRandom() % num_workers;
+  for (int i = 0; i < num_workers; ++i) {
+    int victim = (start + i) % num_workers;
+    if (victim != index && workers_[victim]->deque.Steal(task)) return task;
+  }
+  return nullptr;
+}
+
+void ThreadPool::WaitFor(const std::atomic<int64_t>& pending) {
+  const int index = CurrentWorkerIndex();
+  int spins = 0;
+  while (pending.load(std::memory_order_acquire) != 0) {
+    if (Task* task = FindTask(index)) {
+      task->Run();
+      delete task;
+      spins = 0;
+    } else if (++spins >= kSpinsBeforeSleep) {
+      // Whatever's left is running on other threads.
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ThreadPool::WorkerLoop(int index) {
+  current_pool = this;
+  current_index = index;
+  int spins = 0;
+  while (true) {
+    const uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+    if (Task* task = FindTask(index)) {
+      task->Run();
+      delete task;
+      spins = 0;
+      continue;
+    }
+    if (++spins < kSpinsBeforeSleep) {
+      std::this_thread::yield();
+      continue;
+    }
+    spins = 0;
+    std::unique_lock<std::mutex> lock(mu_);
+    num_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+    wake_.wait(lock, [&] {
+      return stop_ || epoch_.load(std::memory_order_seq_cst) != epoch;
+    });
+    num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+    if (stop_) return;
+  }
+}
@@ -0,0 +1,214 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+// ThreadPool runs loops on all the cores instead of one. It's the shared
+// parallel runtime for bulk operations on the containers in this repo:
+//
+//   std::vector<int> nums_vector = ...;
+//   ThreadPool& pool = ThreadPool::Default();
+//   // Calls fn on [begin, end) sub-ranges, in parallel.
+//   pool.ParallelFor(0, nums_vector.size(), [&](int64_t begin, int64_t end) {
+//     for (int64_t i = begin; i < end; ++i) nums_vector[i] *= 2;
+//   });
+//   // Sums each sub-range, then adds the partial sums together.
+//   int64_t sum = pool.ParallelReduce(
+//       0, nums_vector.size(), int64_t{0},
+//       [&](int64_t begin, int64_t end) {
+//         return std::accumulate(&nums_vector[begin], &nums_vector[end],
+//                                int64_t{0});
+//       },
+//       [](int64_t a, int64_t b) { return a + b; });
+//
+// Under the hood it's work stealing. Each worker thread has a ChaseLevDeque
+// of tasks. A ParallelFor starts as one task covering the whole range, and
+// whoever runs it keeps splitting it in half, pushing the right half onto its
+// own deque and carrying on with the left, until the pieces are down to the
+// grain size. Idle workers steal from the other end of someone else's deque,
+// which is where the biggest pieces are. So work spreads out to however many
+// threads are free without any up-front partitioning, and a thread that gets
+// slow pieces doesn't hold everyone else up.
+//
+// The thread calling ParallelFor/ParallelReduce runs tasks too while it
+// waits, and nesting them (calling ParallelFor from inside a ParallelFor)
+// works. The functions you pass in must not throw.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "chase_lev_deque.h"
+#include "mpmc_queue.h"
+
+class ThreadPool {
+ public:
+  // Starts num_threads worker threads, or one per core if it's 0.
+  explicit ThreadPool(int num_threads = 0);
+  // Has to be called when nothing is running on the pool.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // A pool with one thread per core that's never destroyed. Use this one
+  // unless you have a reason not to, since several pools each with a thread
+  // per core just fight each other.
+  static ThreadPool& Default();
+
+  int num_threads() const { return static_cast<int>(threads_.size()); }
+
+  // Calls fn(sub_begin, sub_end) for sub-ranges that exactly cover
+  // [begin, end), in parallel, and returns once they're all done. Sub-ranges
+  // are at most `grain` long. Small grains balance the load better but add
+  // more overhead per task; 0 picks one that gives each thread about 8
+  // pieces.
+  template <typename Fn>
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain, const Fn& fn);
+  template <typename Fn>
+  void ParallelFor(int64_t begin, int64_t end, const Fn& fn) {
+    ParallelFor(begin, end, 0, fn);
+  }
+
+  // Splits [begin, end) into pieces of `grain` (0 picks one), computes
+  // map(piece_begin, piece_end) for each in parallel, then combines
+  // neighbouring results pairwise, also in parallel, until there's one left.
+  // The combining is always done in the same order, so `combine` only has to
+  // be associative, not commutative. Returns `identity` for an empty range.
+  template <typename T, typename Map, typename Combine>
+  T ParallelReduce(int64_t begin, int64_t end, int64_t grain, T identity,
+                   const Map& map, const Combine& combine);
+  template <typename T, typename Map, typename Combine>
+  T ParallelReduce(int64_t begin, int64_t end, T identity, const Map& map,
+                   const Combine& combine) {
+    return ParallelReduce(begin, end, 0, std::move(identity), map, combine);
+  }
+
+ private:
+  struct Task {
+    virtual ~Task() = default;
+    virtual void Run() = 0;
+  };
+
+  template <typename Fn>
+  struct RangeTask;
+
+  struct alignas(64) Worker {
+    ChaseLevDeque<Task*> deque;
+  };
+
+  int64_t ChooseGrain(int64_t size, int64_t grain) const {
+    if (grain > 0) return grain;
+    return std::max<int64_t>(1, size / (8 * (num_threads() + 1)));
+  }
+
+  // Queues a task. From one of this pool's workers it goes on the worker's
+  // own deque, from anywhere else on injected_.
+  void Spawn(Task* task);
+  // Runs tasks until `pending` drops to 0.
+  void WaitFor(const std::atomic<int64_t>& pending);
+  // Own deque first, then injected_, then steal. `index` is -1 for threads
+  // that aren't workers.
+  Task* FindTask(int index);
+  void WorkerLoop(int index);
+  // Which of this pool's workers the calling thread is, or -1.
+  int CurrentWorkerIndex() const;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  // Tasks from threads outside the pool.
+  MpmcQueue<Task*> injected_;
+
+  // Workers with nothing to do sleep on wake_. epoch_ goes up on every Spawn
+  // so a worker can tell whether anything was spawned between its last look
+  // for tasks and going to sleep.
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<int> num_sleeping_{0};
+  std::mutex mu_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+template <typename Fn>
+struct ThreadPool::RangeTask : Task {
+  RangeTask(ThreadPool* pool, const Fn* fn, std::atomic<int64_t>* pending,
+            int64_t begin, int64_t end, int64_t grain)
+      : pool(pool),
+        fn(fn),
+        pending(pending),
+        begin(begin),
+        end(end),
+        grain(grain) {}
+
+  void Run() override {
+    while (end - begin > grain) {
+      int64_t mid = begin + (end - begin) / 2;
+      // This task still counts as pending, so the count can't hit 0 before
+      // the new one is counted.
+      pending->fetch_add(1, std::memory_order_relaxed);
+      pool->Spawn(new RangeTask(pool, fn, pending, mid, end, grain));
+      end = mid;
+    }
+    (*fn)(begin, end);
+    pending->fetch_sub(1, std::memory_order_release);
+  }
+
+  ThreadPool* pool;
+  const Fn* fn;
+  std::atomic<int64_t>* pending;
+  int64_t begin;
+  int64_t end;
+  int64_t grain;
+};
+
+template <typename Fn>
+void ThreadPool::ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                             const Fn& fn) {
+  if (begin >= end) return;
+  grain = ChooseGrain(end - begin, grain);
+  if (end - begin <= grain || threads_.empty()) {
+    fn(begin, end);
+    return;
+  }
+  std::atomic<int64_t> pending{1};
+  Spawn(new RangeTask<Fn>(this, &fn, &pending, begin, end, grain));
+  WaitFor(pending);
+}
+
+template <typename T, typename Map, typename Combine>
+T ThreadPool::ParallelReduce(int64_t begin, int64_t end, int64_t grain,
+                             T identity, const Map& map,
+                             const Combine& combine) {
+  if (begin >= end) return identity;
+  grain = ChooseGrain(end - begin, grain);
+  const int64_t num_pieces = (end - begin + grain - 1) / grain;
+  std::vector<T> partials(num_pieces, identity);
+  ParallelFor(0, num_pieces, 1, [&](int64_t first, int64_t last) {
+    for (int64_t p = first; p < last; ++p) {
+      int64_t piece_begin = begin + p * grain;
+      partials[p] = map(piece_begin, std::min(end, piece_begin + grain));
+    }
+  });
+  // Round 1 combines pieces 0+1, 2+3, ... into 0, 2, ..., round 2 combines
+  // 0+2, 4+6, ... and so on.
+  for (int64_t stride = 1; stride < num_pieces; stride *= 2) {
+    const int64_t num_pairs = (num_pieces + 2 * stride - 1) / (2 * stride);
+    ParallelFor(0, num_pairs, 1, [&](int64_t first, int64_t last) {
+      for (int64_t pair = first; pair < last; ++pair) {
+        int64_t left = pair * 2 * stride;
+        int64_t right = left + stride;
+        if (right < num_pieces) {
+          partials[left] =
+              combine(std::move(partials[left]), std::move(partials[right]));
+        }
+      }
+    });
+  }
+  return std::move(partials[0]);
+}
+
+#endif  // THREAD_POOL_H_
@@ -0,0 +1,77 @@
+#ifndef UNINITIALIZED_H_
+#define UNINITIALIZED_H_
+
+// Ways to get big buffers of ints without paying to zero them first.
+//
+// std::make_unique<int[]>(n) and std::vector<int>(n) both set every element
+// to 0. That's usually what you want, but if you're about to overwrite the
+// whole thing anyway it's a wasted pass over memory, which for a 1 GB buffer
+// is a big chunk of the total time. `new int[n]` skips the zeroing, and so do
+// the helpers here, but without giving up unique_ptr or vector.
+//
+// The catch is the same as with `int x;`: the values start out as garbage, so
+// reading one before you write it is a bug. Types with a constructor (like
+// std::string) still get constructed normally, so this only matters for ints,
+// floats, plain structs and so on.
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Same as C++20's std::make_unique_for_overwrite. Use it for arrays where
+// you'd otherwise write std::make_unique<int[]>(n):
+//   std::unique_ptr<int[]> nums = MakeUniqueForOverwrite<int[]>(n);
+template <typename T>
+std::enable_if_t<!std::is_array_v<T>, std::unique_ptr<T>>
+MakeUniqueForOverwrite() {
+  return std::unique_ptr<T>(new T);
+}
+template <typename T>
+std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0,
+                 std::unique_ptr<T>>
+MakeUniqueForOverwrite(size_t n) {
+  return std::unique_ptr<T>(new std::remove_extent_t<T>[n]);
+}
+
+// An allocator that default-initializes instead of value-initializing. The
+// only difference from the allocator it wraps is what happens when a
+// container constructs an element with no arguments, which is what
+// vector(n), resize(n) and emplace_back() do. For ints that means no zeroing.
+// Constructing with arguments (push_back(5)) works the same as usual.
+template <typename T, typename Base = std::allocator<T>>
+class DefaultInitAllocator : public Base {
+  using BaseTraits = std::allocator_traits<Base>;
+
+ public:
+  template <typename U>
+  struct rebind {
+    using other = DefaultInitAllocator<
+        U, typename BaseTraits::template rebind_alloc<U>>;
+  };
+
+  using Base::Base;
+  DefaultInitAllocator() = default;
+  template <typename U, typename OtherBase>
+  DefaultInitAllocator(const DefaultInitAllocator<U, OtherBase>& other) noexcept
+      : Base(static_cast<const OtherBase&>(other)) {}
+
+  template <typename U>
+  void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+  template <typename U, typename... Args>
+  void construct(U* ptr, Args&&... args) {
+    BaseTraits::construct(static_cast<Base&>(*this), ptr,
+                          std::forward<Args>(args)...);
+  }
+};
+
+// A std::vector<T> that doesn't zero new elements:
+//   DefaultInitVector<int> nums(n);  // Garbage values, fill them in yourself.
+template <typename T>
+using DefaultInitVector = std::vector<T, DefaultInitAllocator<T>>;
+
+#endif  // UNINITIALIZED_H_
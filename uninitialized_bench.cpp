@@ -0,0 +1,98 @@
+// How much time zero-filling costs on big int buffers that get overwritten
+// right away anyway. Run with:
+//   bazel run -c opt :uninitialized_bench
+//
+// Every benchmark allocates a buffer, writes every element once, and frees
+// it. The times include the page faults from touching fresh memory, which
+// every version pays, so the difference between the pairs is the zeroing.
+// Sizes go up to 1 GB.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "uninitialized.h"
+
+namespace {
+
+template <typename Ptr>
+void Overwrite(Ptr& nums, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) nums[i] = static_cast<int>(i);
+  benchmark::ClobberMemory();
+}
+
+int64_t NumInts(const benchmark::State& state) {
+  return state.range(0) / sizeof(int);
+}
+
+void SetBytes(benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// The `num_array_unique` example from Arrays().
+void BM_MakeUnique(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  for (auto _ : state) {
+    std::unique_ptr<int[]> nums = std::make_unique<int[]>(n);
+    Overwrite(nums, n);
+  }
+  SetBytes(state);
+}
+
+void BM_MakeUniqueForOverwrite(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  for (auto _ : state) {
+    std::unique_ptr<int[]> nums = MakeUniqueForOverwrite<int[]>(n);
+    Overwrite(nums, n);
+  }
+  SetBytes(state);
+}
+
+// The `nums_vector` example from Arrays().
+template <typename Vector>
+void BM_SizedVector(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  for (auto _ : state) {
+    Vector nums(n);
+    Overwrite(nums, n);
+  }
+  SetBytes(state);
+}
+
+// Growing with resize() in steps, like reading a file in chunks.
+template <typename Vector>
+void BM_ResizeInChunks(benchmark::State& state) {
+  const int64_t n = NumInts(state);
+  constexpr int64_t kChunk = 1 << 16;
+  for (auto _ : state) {
+    Vector nums;
+    for (int64_t start = 0; start < n; start += kChunk) {
+      int64_t end = std::min(start + kChunk, n);
+      nums.resize(end);
+      for (int64_t i = start; i < end; ++i) nums[i] = static_cast<int>(i);
+    }
+    benchmark::ClobberMemory();
+  }
+  SetBytes(state);
+}
+
+void BufferSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(16)
+      ->Range(1 << 20, 1 << 30)
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_MakeUnique)->Apply(BufferSizes);
+BENCHMARK(BM_MakeUniqueForOverwrite)->Apply(BufferSizes);
+BENCHMARK_TEMPLATE(BM_SizedVector, std::vector<int>)->Apply(BufferSizes);
+BENCHMARK_TEMPLATE(BM_SizedVector, DefaultInitVector<int>)
+    ->Apply(BufferSizes);
+BENCHMARK_TEMPLATE(BM_ResizeInChunks, std::vector<int>)->Apply(BufferSizes);
+BENCHMARK_TEMPLATE(BM_ResizeInChunks, DefaultInitVector<int>)
+    ->Apply(BufferSizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();